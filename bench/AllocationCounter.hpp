@@ -0,0 +1,48 @@
+#pragma once
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <atomic>
+
+// Counts the allocations made through the global operator new, only when built with LD46_COUNT_ALLOCATIONS
+namespace AllocationCounter
+{
+#ifdef LD46_COUNT_ALLOCATIONS
+    constexpr bool enabled = true;
+#else
+    constexpr bool enabled = false;
+#endif
+
+    std::atomic<size_t>& Counter()
+    {
+        static std::atomic<size_t> counter{0};
+        return counter;
+    }
+
+    size_t Count()
+    {
+        return Counter().load(std::memory_order_relaxed);
+    }
+}
+
+#ifdef LD46_COUNT_ALLOCATIONS
+void* operator new(std::size_t size)
+{
+    AllocationCounter::Counter().fetch_add(1, std::memory_order_relaxed);
+    if (void* ptr = std::malloc(size ? size : 1))
+    {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t size) noexcept
+{
+    std::free(ptr);
+}
+#endif
@@ -0,0 +1,122 @@
+#pragma once
+#include "Bench.hpp"
+#include "AssetPack.hpp"
+#include "ResourceCache.hpp"
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#ifndef LD46_BENCH_ASSETS_DIR
+#define LD46_BENCH_ASSETS_DIR "Assets"
+#endif
+
+namespace
+{
+    constexpr auto assetRepeats = 50;
+    const char* packedAssetNames[] = {"Carrot.png", "Hearth.png", "Plant.png", "Player.png", "Rabbit.png", "RabbitUI.png", "Tileset.png", "TurnipUI.png", "Level.txt"};
+}
+
+// Startup cost of the assets the game reads through the archive: reading and decoding the loose files
+// against opening the archive and looking every entry up, raw and compressed
+void RunAssetScenarios()
+{
+    std::vector<AssetPack::PackSource> sources;
+    Bench::Timer looseTimer;
+    for (int r = 0; r < assetRepeats; r++)
+    {
+        sources.clear();
+        for (auto name : packedAssetNames)
+        {
+            sources.emplace_back();
+            if (!AssetPack::ReadSource(LD46_BENCH_ASSETS_DIR, name, sources.back()))
+            {
+                return;
+            }
+        }
+    }
+    Bench::Report("assets", "loose", "load_all", looseTimer.Milliseconds() / assetRepeats, "ms");
+
+    for (bool compress : {false, true})
+    {
+        std::string scenario = compress ? "packed_lz" : "packed";
+        auto file = (std::filesystem::temp_directory_path() / ("ld46_bench_" + scenario + ".pack")).string();
+        if (!AssetPack::WriteArchive(file.c_str(), sources, compress))
+        {
+            return;
+        }
+        Bench::Report("assets", scenario, "archive_size", std::filesystem::file_size(file), "bytes");
+
+        size_t bytes = 0;
+        Bench::Timer packedTimer;
+        for (int r = 0; r < assetRepeats; r++)
+        {
+            AssetArchive archive;
+            archive.Open(file.c_str());
+            for (auto& source : sources)
+            {
+                auto view = archive.Find(source.path);
+                if (!Bench::Check(view && view->data.size() == source.data.size(), "assets", scenario, source.path + " packed"))
+                {
+                    continue;
+                }
+                bytes += view->data.size() + (unsigned char) view->data.back();
+            }
+        }
+        Bench::Report("assets", scenario, "load_all", packedTimer.Milliseconds() / assetRepeats, "ms");
+        Bench::Keep(bytes);
+
+        AssetArchive archive;
+        archive.Open(file.c_str());
+        for (auto& source : sources)
+        {
+            auto view = archive.Find(source.path);
+            Bench::Check(view && view->data == std::string_view(reinterpret_cast<const char*>(source.data.data()), source.data.size()),
+                         "assets", scenario, source.path + " unpacks to its source");
+        }
+
+        // A restart drops every handle and loads the images again, while anything still holds them they are hits
+        std::vector<std::string> images;
+        for (auto& source : sources)
+        {
+            if (source.kind == AssetPack::Kind::Image)
+            {
+                images.push_back(source.path);
+            }
+        }
+        ResourceCache cache(archive);
+        std::vector<Resource<tako::Bitmap>> held;
+        Bench::Timer coldTimer;
+        for (int r = 0; r < assetRepeats; r++)
+        {
+            held.clear();
+            for (auto& image : images)
+            {
+                held.push_back(cache.Bitmap(image.c_str()));
+            }
+        }
+        Bench::Report("assets", scenario, "cache_cold", coldTimer.Milliseconds() / assetRepeats, "ms");
+        Bench::Timer warmTimer;
+        for (int r = 0; r < assetRepeats; r++)
+        {
+            for (auto& image : images)
+            {
+                auto again = cache.Bitmap(image.c_str());
+                Bench::Check(again.Get() == held[&image - images.data()].Get(), "assets", scenario, image + " is shared");
+            }
+        }
+        Bench::Report("assets", scenario, "cache_warm", warmTimer.Milliseconds() / assetRepeats, "ms");
+        int hits = 0;
+        size_t cached = 0;
+        cache.ForEachStat([&](ResourceKind, const std::string&, const ResourceStats& stats)
+        {
+            hits += stats.hits;
+            cached += stats.bytes;
+        });
+        Bench::Report("assets", scenario, "cache_hits", hits, "count");
+        Bench::Report("assets", scenario, "cache_bytes", cached, "bytes");
+        held.clear();
+        Bench::Check(cache.Count() == 0, "assets", scenario, "cache empty once nothing holds a resource");
+        std::filesystem::remove(file);
+    }
+}
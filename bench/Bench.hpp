@@ -0,0 +1,87 @@
+#pragma once
+#include <chrono>
+#include <cstdio>
+#include <string_view>
+#ifdef __linux__
+#include <unistd.h>
+#endif
+
+namespace Bench
+{
+    using Clock = std::chrono::steady_clock;
+
+    class Timer
+    {
+    public:
+        Timer() : m_start(Clock::now()) {}
+
+        double Milliseconds()
+        {
+            return std::chrono::duration<double, std::milli>(Clock::now() - m_start).count();
+        }
+
+    private:
+        Clock::time_point m_start;
+    };
+
+    // One JSON object per line so results can be collected and compared across builds
+    void Report(std::string_view suite, std::string_view scenario, std::string_view metric, double value, std::string_view unit)
+    {
+        printf("{\"suite\":\"%.*s\",\"scenario\":\"%.*s\",\"metric\":\"%.*s\",\"value\":%.6f,\"unit\":\"%.*s\"}\n",
+               (int) suite.size(), suite.data(),
+               (int) scenario.size(), scenario.data(),
+               (int) metric.size(), metric.data(),
+               value,
+               (int) unit.size(), unit.data());
+        fflush(stdout);
+    }
+
+    size_t& Failures()
+    {
+        static size_t failures = 0;
+        return failures;
+    }
+
+    // Unlike assert it stays in release builds, a failed check is printed and makes the bench exit nonzero
+    bool Check(bool passed, std::string_view suite, std::string_view scenario, std::string_view check)
+    {
+        if (!passed)
+        {
+            fprintf(stderr, "Check failed in %.*s/%.*s: %.*s\n",
+                    (int) suite.size(), suite.data(),
+                    (int) scenario.size(), scenario.data(),
+                    (int) check.size(), check.data());
+            Failures()++;
+        }
+        return passed;
+    }
+
+    // Keeps the compiler from dropping work whose result is otherwise unused
+    template<typename T>
+    void Keep(T value)
+    {
+        static volatile T sink;
+        sink = value;
+    }
+
+    size_t ResidentMemory()
+    {
+#ifdef __linux__
+        size_t pages = 0;
+        size_t resident = 0;
+        FILE* statm = fopen("/proc/self/statm", "r");
+        if (!statm)
+        {
+            return 0;
+        }
+        if (fscanf(statm, "%zu %zu", &pages, &resident) != 2)
+        {
+            resident = 0;
+        }
+        fclose(statm);
+        return resident * sysconf(_SC_PAGESIZE);
+#else
+        return 0;
+#endif
+    }
+}
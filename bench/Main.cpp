@@ -0,0 +1,503 @@
+#include "Bench.hpp"
+#include "LevelGenerator.hpp"
+#include "Game.hpp"
+#include "AllocationCounter.hpp"
+#include "Rollback.hpp"
+#include "Micro.hpp"
+#include "Raster.hpp"
+#include "Assets.hpp"
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <random>
+#include <memory>
+#include <chrono>
+#include <algorithm>
+
+namespace
+{
+    constexpr auto frameDt = 1.0f / 60;
+    // What stepping the simulation again after late inputs may cost at most
+    constexpr auto rollbackBudget = 1.0;
+}
+
+struct Scenario
+{
+    std::string name;
+    std::string level;
+};
+
+// Plays the level headless with nobody at the controls, long enough for the slowest plant to ripen
+void RunLevelScenario(const Scenario& scenario)
+{
+    constexpr auto frames = 1200;
+    auto memoryBefore = Bench::ResidentMemory();
+    Bench::Timer startTimer;
+    auto game = std::make_unique<Game>();
+    game->StartGame(7, scenario.level, false);
+    Bench::Report("level", scenario.name, "start", startTimer.Milliseconds(), "ms");
+    Bench::Report("level", scenario.name, "memory", Bench::ResidentMemory() - memoryBefore, "bytes");
+
+    InputLatency::Clock::time_point start;
+    double totalFrame = 0;
+    double maxFrame = 0;
+    size_t steadyAllocations = 0;
+    size_t lastPeak = 0;
+    // Sum of the peaks of every component, it rises whenever any of them does
+    auto peakSum = [&]()
+    {
+        size_t sum = 0;
+        game->Census().HighWater().ForEach([&](auto component, size_t count)
+        {
+            sum += count;
+        });
+        return sum;
+    };
+    for (int frame = 0; frame < frames; frame++)
+    {
+        auto peakBefore = peakSum();
+        auto allocationsBefore = AllocationCounter::Count();
+        Bench::Timer frameTimer;
+        game->Simulate(0, frameDt, start + std::chrono::duration_cast<InputLatency::Clock::duration>(std::chrono::duration<double>(frame * frameDt)));
+        game->PublishRenderFrame();
+        auto elapsed = frameTimer.Milliseconds();
+        totalFrame += elapsed;
+        maxFrame = std::max(maxFrame, elapsed);
+        // The first two frames grow the persistent scratch buffers and both render lists. A new peak of any component
+        // grows the world, and the render lists over that frame and the next. Any other frame must not touch the heap
+        auto peak = peakSum();
+        if (frame > 1 && peak == peakBefore && peakBefore == lastPeak)
+        {
+            steadyAllocations += AllocationCounter::Count() - allocationsBefore;
+        }
+        lastPeak = peakBefore;
+    }
+    Bench::Report("level", scenario.name, "frame_avg", totalFrame / frames, "ms");
+    Bench::Report("level", scenario.name, "frame_max", maxFrame, "ms");
+    Bench::Report("level", scenario.name, "tile_memory", game->TileMemory(), "bytes");
+    game->ReadRenderFrame([&](const RenderFrame& frame)
+    {
+        Bench::Report("level", scenario.name, "carrot_health", frame.carrotHealth, "hp");
+    });
+    auto& peaks = game->Census().HighWater();
+    Bench::Report("level", scenario.name, "spawners", peaks.Get<Spawner>(), "count");
+    Bench::Report("level", scenario.name, "peak_rabbits", peaks.Get<Enemy>(), "count");
+
+    SimulationState state;
+    game->SaveState(state);
+    size_t ripe = 0;
+    for (auto& [index, plant] : state.world.Saved<Plant>())
+    {
+        ripe += plant.Stage(state.step) == 2;
+    }
+    Bench::Report("level", scenario.name, "plants_ripe", ripe, "count");
+    Bench::Check(ripe == state.world.Saved<Plant>().size(), "level", scenario.name, "every plant ripe");
+    if (AllocationCounter::enabled)
+    {
+        Bench::Report("level", scenario.name, "heap_allocations", steadyAllocations, "count");
+        Bench::Check(steadyAllocations == 0, "level", scenario.name, std::to_string(steadyAllocations) + " heap allocations in steady frames");
+    }
+
+    auto streamed = std::make_unique<Game>();
+    Bench::Timer streamTimer;
+    streamed->StartGame(7, scenario.level, true);
+    streamed->Simulate(0, frameDt, start);
+    Bench::Report("level", scenario.name, "stream_start", streamTimer.Milliseconds(), "ms");
+    Bench::Report("level", scenario.name, "tile_memory_streamed", streamed->TileMemory(), "bytes");
+}
+
+// Two players stand too far apart to share a chunk, after a while one of them walks into chunks paged out since the start
+void RunStreamingScenario()
+{
+    constexpr auto idleFrames = 1200;
+    constexpr auto walkFrames = 600;
+    auto game = std::make_unique<Game>();
+    game->StartGame(7, GenerateLevel({400, 40, 80, 300, 5, 2, 100}), true);
+
+    SimulationState state;
+    bool streamedIn = true;
+    double totalFrame = 0;
+    double maxFrame = 0;
+    size_t maxRabbits = 0;
+    for (int frame = 0; frame < idleFrames + walkFrames; frame++)
+    {
+        std::array<PlayerInput, 2> inputs = {frame < idleFrames ? PlayerInput(0) : PlayerInput(InputButton::Right), 0};
+        Bench::Timer frameTimer;
+        game->Step(inputs.data(), inputs.size());
+        auto elapsed = frameTimer.Milliseconds();
+        totalFrame += elapsed;
+        maxFrame = std::max(maxFrame, elapsed);
+
+        game->SaveState(state);
+        maxRabbits = std::max(maxRabbits, state.world.Saved<Enemy>().size());
+        for (auto& [player, unused] : state.world.Saved<Player>())
+        {
+            for (auto& [index, pos] : state.world.Saved<Position>())
+            {
+                if (index == player)
+                {
+                    streamedIn &= game->IsStreamedIn({pos.x, pos.y});
+                }
+            }
+        }
+    }
+    Bench::Report("streaming", "split_players", "frame_avg", totalFrame / (idleFrames + walkFrames), "ms");
+    Bench::Report("streaming", "split_players", "frame_max", maxFrame, "ms");
+    Bench::Report("streaming", "split_players", "tile_memory", game->TileMemory(), "bytes");
+    Bench::Report("streaming", "split_players", "peak_rabbits", maxRabbits, "count");
+    Bench::Check(state.world.Saved<Player>().size() == 2, "streaming", "split_players", "two players");
+    Bench::Check(streamedIn, "streaming", "split_players", "every player's chunk stays loaded");
+}
+
+tako::U32 StateChecksum(SimulationState& state)
+{
+    tako::U32 hash = 2166136261u;
+    auto mix = [&](const void* data, size_t size)
+    {
+        auto bytes = static_cast<const tako::U8*>(data);
+        for (size_t i = 0; i < size; i++)
+        {
+            hash = (hash ^ bytes[i]) * 16777619u;
+        }
+    };
+    for (auto& [index, pos] : state.world.Saved<Position>())
+    {
+        mix(&index, sizeof(index));
+        mix(&pos, sizeof(pos));
+    }
+    for (auto& [index, player] : state.world.Saved<Player>())
+    {
+        mix(&player.hunger, sizeof(player.hunger));
+    }
+    mix(&state.score, sizeof(state.score));
+    mix(&state.random, sizeof(state.random));
+    return hash;
+}
+
+// Two headless games play the same level in lockstep, each sending its inputs over a delayed and lossy loopback channel
+void RunRollbackScenario(const std::string& name, const std::string& level, int latency, float loss)
+{
+    constexpr auto players = 2;
+    constexpr auto frames = 600;
+    using Session = RollbackSession<Game, SimulationState>;
+    std::vector<std::unique_ptr<Game>> games;
+    std::vector<Session> sessions(players);
+    std::vector<LoopbackTransport> channels;
+    std::vector<Random> pads(players);
+    std::vector<PlayerInput> held(players, 0);
+    std::vector<std::vector<tako::U32>> checksums(players);
+    for (int slot = 0; slot < players; slot++)
+    {
+        games.push_back(std::make_unique<Game>());
+        games[slot]->StartGame(7, level, false);
+        sessions[slot].Setup(games[slot].get(), players, slot);
+        channels.emplace_back(latency, loss, slot + 1);
+        pads[slot].Seed(slot + 11);
+    }
+
+    double totalAdvance = 0;
+    double maxAdvance = 0;
+    double maxRollback = 0;
+    int advances = 0;
+    int stalls = 0;
+    int maxResimulated = 0;
+    double totalRollback = 0;
+    int resimulated = 0;
+    std::vector<double> rollbacks;
+    while (sessions[0].Frame() < frames || sessions[1].Frame() < frames)
+    {
+        for (int slot = 0; slot < players; slot++)
+        {
+            auto& pad = pads[slot];
+            if (pad.Int(20) == 0)
+            {
+                held[slot] = pad.Next() & (InputButton::Left | InputButton::Right | InputButton::Jump);
+            }
+            PlayerInput input = held[slot] | (pad.Int(90) == 0 ? InputButton::Throw : 0) | (pad.Int(200) == 0 ? InputButton::Eat : 0);
+            int confirmed = sessions[slot].ConfirmedFrame();
+            Bench::Timer advanceTimer;
+            bool advanced = sessions[slot].Frame() < frames && sessions[slot].Advance(input);
+            auto elapsed = advanceTimer.Milliseconds();
+            if (advanced)
+            {
+                totalAdvance += elapsed;
+                maxAdvance = std::max(maxAdvance, elapsed);
+                advances++;
+                if (sessions[slot].Resimulated() > 0)
+                {
+                    maxRollback = std::max(maxRollback, elapsed);
+                    totalRollback += elapsed;
+                    rollbacks.push_back(elapsed);
+                    resimulated += sessions[slot].Resimulated();
+                    maxResimulated = std::max(maxResimulated, sessions[slot].Resimulated());
+                }
+            }
+            else if (sessions[slot].Frame() < frames)
+            {
+                stalls++;
+            }
+            if (sessions[slot].ConfirmedFrame() != confirmed)
+            {
+                checksums[slot].resize(sessions[slot].ConfirmedFrame() + 1, 0);
+                checksums[slot].back() = StateChecksum(sessions[slot].ConfirmedState());
+            }
+            channels[slot].Send(sessions[slot].MakePacket(1 - slot));
+        }
+        for (int slot = 0; slot < players; slot++)
+        {
+            channels[slot].Tick();
+            InputPacket packet;
+            while (channels[1 - slot].Receive(packet))
+            {
+                sessions[slot].Receive(packet);
+            }
+        }
+    }
+
+    int checked = 0;
+    int desyncs = 0;
+    for (int frame = 0; frame < std::min(checksums[0].size(), checksums[1].size()); frame++)
+    {
+        if (checksums[0][frame] && checksums[1][frame])
+        {
+            checked++;
+            desyncs += checksums[0][frame] != checksums[1][frame];
+        }
+    }
+    Bench::Report("rollback", name, "entities", sessions[0].ConfirmedState().world.EntityCount(), "count");
+    Bench::Report("rollback", name, "advance_avg", totalAdvance / advances, "ms");
+    Bench::Report("rollback", name, "advance_max", maxAdvance, "ms");
+    Bench::Report("rollback", name, "rollback_max", maxRollback, "ms");
+    std::sort(rollbacks.begin(), rollbacks.end());
+    Bench::Report("rollback", name, "rollback_p99", rollbacks.empty() ? 0 : rollbacks[rollbacks.size() * 99 / 100], "ms");
+    Bench::Report("rollback", name, "rollbacks_over_budget", rollbacks.end() - std::upper_bound(rollbacks.begin(), rollbacks.end(), rollbackBudget), "count");
+    Bench::Report("rollback", name, "resimulated_max", maxResimulated, "frames");
+    Bench::Report("rollback", name, "resimulated_frame_avg", totalRollback / std::max(1, resimulated), "ms");
+    Bench::Report("rollback", name, "stalls", stalls, "count");
+    Bench::Report("rollback", name, "checked_frames", checked, "count");
+    Bench::Report("rollback", name, "desyncs", desyncs, "count");
+    Bench::Check(desyncs == 0, "rollback", name, std::to_string(desyncs) + " confirmed frames differ between the peers");
+
+    // Peaks of a real session, what Game::SetCapacityHints would be given to size the pools for it
+    auto& peaks = games[0]->Census().HighWater();
+    Bench::Report("rollback", name, "peak_entities", peaks.Get<Position>() + peaks.Get<Spawner>(), "count");
+    Bench::Report("rollback", name, "peak_particles", peaks.Get<Particle>(), "count");
+    Bench::Report("rollback", name, "peak_rabbits", peaks.Get<Enemy>(), "count");
+    Bench::Report("rollback", name, "peak_corpses", peaks.Get<DeadEnemy>(), "count");
+    Bench::Check(peaks.Get<Player>() == 2, "rollback", name, "two players");
+
+    // Draw only sees the published render list, it has to hold the visible tiles and every visible entity in layer order
+    games[0]->PublishRenderFrame();
+    games[0]->ReadRenderFrame([&](const RenderFrame& frame)
+    {
+        Rect view(frame.camera, frame.viewSize);
+        Bench::Check(!frame.tiles.empty() && std::all_of(frame.tiles.begin(), frame.tiles.end(), [&](const RenderItem& tile)
+        {
+            return Rect::Overlap(Rect(tile.position, tile.size + tako::Vector2(32, 32)), view);
+        }), "rollback", name, "tiles around the view");
+        Bench::Check(std::is_sorted(frame.items.begin(), frame.items.end(), [](const RenderItem& a, const RenderItem& b)
+        {
+            return a.layer < b.layer;
+        }), "rollback", name, "render items in layer order");
+        Bench::Report("rollback", name, "render_tiles", frame.tiles.size(), "count");
+        Bench::Report("rollback", name, "render_items", frame.items.size(), "count");
+    });
+
+    // A restart has to come out the same as starting the level again
+    auto fresh = std::make_unique<Game>();
+    fresh->StartGame(7, level, false);
+    SimulationState restarted;
+    SimulationState started;
+    Bench::Timer restartTimer;
+    games[0]->Restart();
+    Bench::Report("rollback", name, "restart", restartTimer.Milliseconds(), "ms");
+    games[0]->SaveState(restarted);
+    fresh->SaveState(started);
+    Bench::Check(StateChecksum(restarted) == StateChecksum(started), "rollback", name, "restart matches a fresh start");
+}
+
+// A scripted pad changes at arbitrary moments, every frame updates at its start and draws half a frame later.
+// The game measures from the first sample of an edge, the script knows when it really changed
+void RunInputLatencyScenario(const std::string& level, int refreshRate)
+{
+    constexpr auto seconds = 20;
+    float frameTime = 1.0f / refreshRate;
+    int frames = seconds * refreshRate;
+    std::vector<std::pair<double, PlayerInput>> script;
+    Random pad;
+    pad.Seed(5);
+    PlayerInput buttons = 0;
+    for (double t = 0.5; t < seconds - 1; t += 0.05 + pad.Int(20) * 0.02)
+    {
+        PlayerInput next;
+        do
+        {
+            next = pad.Next() & (InputButton::Left | InputButton::Right | InputButton::Jump);
+        } while (next == buttons);
+        buttons = next;
+        script.push_back({t, buttons});
+    }
+    auto scripted = [&](double t)
+    {
+        auto change = std::upper_bound(script.begin(), script.end(), t, [](double t, const std::pair<double, PlayerInput>& change)
+        {
+            return t < change.first;
+        });
+        return change == script.begin() ? PlayerInput(0) : std::prev(change)->second;
+    };
+
+    std::vector<tako::U32> checksums;
+    for (bool latch : {false, true})
+    {
+        std::string scenario = std::to_string(refreshRate) + (latch ? "hz_latched" : "hz");
+        auto game = std::make_unique<Game>();
+        game->SetLateLatch(latch);
+        game->StartGame(7, level, false);
+        NullDrawer drawer;
+        InputLatency::Clock::time_point start;
+        auto at = [&](double t)
+        {
+            return start + std::chrono::duration_cast<InputLatency::Clock::duration>(std::chrono::duration<double>(t));
+        };
+        size_t shown = 0;
+        double changeToDraw = 0;
+        double maxChangeToDraw = 0;
+        for (int frame = 0; frame < frames; frame++)
+        {
+            double update = frame * double(frameTime);
+            double draw = update + frameTime / 2;
+            game->Simulate(scripted(update), frameTime, at(update));
+            game->PublishRenderFrame();
+            game->ReadRenderFrame([&](const RenderFrame& published)
+            {
+                auto view = game->Latch(published, scripted(draw), at(draw));
+                SubmitRenderItems(&drawer, published.items, view.item, view.player);
+            });
+            // Changes are far enough apart that each one is a single edge shown before the next comes in
+            for (auto edges = game->LatencyStats().edges; shown < edges; shown++)
+            {
+                double latency = (draw - script[shown].first) * 1000;
+                changeToDraw += latency;
+                maxChangeToDraw = std::max(maxChangeToDraw, latency);
+            }
+        }
+        auto stats = game->LatencyStats();
+        Bench::Check(stats.edges == script.size() && stats.dropped == 0, "input", scenario, "every scripted change shown once");
+        Bench::Report("input", scenario, "edges", stats.edges, "count");
+        Bench::Report("input", scenario, "latency_frames_avg", stats.AverageFrames(), "frames");
+        Bench::Report("input", scenario, "latency_frames_max", stats.maxFrames, "frames");
+        Bench::Report("input", scenario, "latency_avg", stats.AverageMilliseconds(), "ms");
+        Bench::Report("input", scenario, "latency_max", stats.maxMilliseconds, "ms");
+        Bench::Report("input", scenario, "change_to_draw_avg", changeToDraw / std::max<size_t>(1, shown), "ms");
+        Bench::Report("input", scenario, "change_to_draw_max", maxChangeToDraw, "ms");
+        Bench::Keep(drawer.area);
+
+        // The latch only moves what is drawn, the simulation has to come out the same
+        SimulationState state;
+        game->SaveState(state);
+        checksums.push_back(StateChecksum(state));
+    }
+    Bench::Check(checksums[0] == checksums[1], "input", std::to_string(refreshRate) + "hz", "latch leaves the simulation alone");
+}
+
+void RunSimdScenarios()
+{
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> coord(0, 4096);
+    std::uniform_real_distribution<float> extent(1, 16);
+    for (size_t count : {1000, 10000, 100000})
+    {
+        std::vector<float> x(count), y(count), w(count), h(count), vx(count), vy(count), tx(count), ty(count);
+        std::vector<tako::U8> hits(count);
+        for (size_t i = 0; i < count; i++)
+        {
+            x[i] = coord(rng);
+            y[i] = coord(rng);
+            w[i] = extent(rng);
+            h[i] = extent(rng);
+            vx[i] = extent(rng);
+            vy[i] = extent(rng);
+        }
+        auto scenario = std::to_string(count);
+        constexpr auto repeats = 200;
+        Rect probe(2048, 2048, 256, 256);
+
+        Bench::Timer scalarOverlap;
+        for (int r = 0; r < repeats; r++)
+        {
+            Simd::OverlapScalar(probe, x.data(), y.data(), w.data(), h.data(), count, hits.data());
+        }
+        Bench::Report("simd", scenario, "overlap_scalar", scalarOverlap.Milliseconds() * 1e6 / (repeats * count), "ns/rect");
+
+        Bench::Timer overlap;
+        for (int r = 0; r < repeats; r++)
+        {
+            Simd::Overlap(probe, x.data(), y.data(), w.data(), h.data(), count, hits.data());
+        }
+        Bench::Report("simd", scenario, std::string("overlap_") + Simd::KernelName(), overlap.Milliseconds() * 1e6 / (repeats * count), "ns/rect");
+
+        Bench::Timer scalarIntegrate;
+        for (int r = 0; r < repeats; r++)
+        {
+            Simd::IntegrateScalar(x.data(), y.data(), vx.data(), vy.data(), tx.data(), ty.data(), count, frameDt, 50);
+        }
+        Bench::Report("simd", scenario, "integrate_scalar", scalarIntegrate.Milliseconds() * 1e6 / (repeats * count), "ns/body");
+
+        Bench::Timer integrate;
+        for (int r = 0; r < repeats; r++)
+        {
+            Simd::Integrate(x.data(), y.data(), vx.data(), vy.data(), tx.data(), ty.data(), count, frameDt, 50);
+        }
+        Bench::Report("simd", scenario, std::string("integrate_") + Simd::KernelName(), integrate.Milliseconds() * 1e6 / (repeats * count), "ns/body");
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    std::vector<Scenario> scenarios;
+    const char* dumpFrame = nullptr;
+    if (argc > 1)
+    {
+        for (int i = 1; i < argc; i++)
+        {
+            if (std::string_view(argv[i]) == "--dump-frame" && i + 1 < argc)
+            {
+                dumpFrame = argv[++i];
+                continue;
+            }
+            std::ifstream file(argv[i], std::ios::binary);
+            if (!file)
+            {
+                fprintf(stderr, "Could not read %s\n", argv[i]);
+                return 1;
+            }
+            std::stringstream content;
+            content << file.rdbuf();
+            scenarios.push_back({argv[i], content.str()});
+        }
+    }
+    if (scenarios.empty())
+    {
+        scenarios.push_back({"small", GenerateLevel({47, 13, 4, 30, 1})});
+        scenarios.push_back({"medium", GenerateLevel({1000, 100, 200, 2000, 2})});
+        scenarios.push_back({"huge", GenerateLevel({10000, 1000, 2000, 20000, 3})});
+    }
+
+    RunSimdScenarios();
+    RunMicroScenarios();
+    RunRasterScenarios(dumpFrame);
+    RunAssetScenarios();
+    RunStreamingScenario();
+    auto versus = GenerateLevel({47, 13, 4, 30, 1, 2});
+    RunRollbackScenario("lan", versus, 1, 0);
+    RunRollbackScenario("internet", versus, 4, 0.05f);
+    RunRollbackScenario("lossy", versus, 6, 0.2f);
+    RunInputLatencyScenario(versus, 60);
+    RunInputLatencyScenario(versus, 144);
+    for (auto& scenario : scenarios)
+    {
+        RunLevelScenario(scenario);
+    }
+    return Bench::Failures() > 0;
+}
@@ -0,0 +1,313 @@
+#pragma once
+#include "Bench.hpp"
+#include "LevelGenerator.hpp"
+#include "Game.hpp"
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+#include <memory>
+#include <array>
+#include <cmath>
+
+namespace
+{
+    constexpr auto microRepeats = 5;
+    constexpr auto microMovers = 100;
+    constexpr auto microEnemySteps = 360;
+    constexpr auto microEnemyOutcomeSteps = 3600;
+    constexpr auto microEnemyOutcomeSlack = 30;
+}
+
+// Stands in for tako::PixelArtDrawer so draw passes can be timed without a window.
+// It only sums up what it is given, so the calls can't be optimized away
+struct NullDrawer
+{
+    size_t calls = 0;
+    float area = 0;
+
+    void DrawSprite(float x, float y, float w, float h, tako::Sprite* sprite)
+    {
+        calls++;
+        area += w * h;
+    }
+
+    void DrawRectangle(float x, float y, float w, float h, tako::Color color)
+    {
+        calls++;
+        area += w * h;
+    }
+
+    void DrawImage(float x, float y, float w, float h, tako::Texture* texture)
+    {
+        calls++;
+        area += w * h;
+    }
+};
+
+// Random 12x12 boxes spread over the level bounds
+std::vector<Rect> MicroBoxes(Level& level, size_t count, std::mt19937& rng)
+{
+    auto bounds = level.MapBounds();
+    std::uniform_real_distribution<float> x(bounds.Left(), bounds.Right());
+    std::uniform_real_distribution<float> y(bounds.Bottom(), bounds.Top());
+    std::vector<Rect> boxes;
+    for (size_t i = 0; i < count; i++)
+    {
+        boxes.emplace_back(x(rng), y(rng), 12, 12);
+    }
+    return boxes;
+}
+
+void RunLevelMicro(const std::string& name, const std::string& levelStr, size_t count)
+{
+    auto scenario = name + "_" + std::to_string(count);
+    LevelCallbacks noCallbacks;
+    Level level(levelStr, noCallbacks);
+    std::mt19937 rng(count);
+    auto boxes = MicroBoxes(level, count, rng);
+
+    size_t hits = 0;
+    Bench::Timer rectTimer;
+    for (int r = 0; r < microRepeats; r++)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            hits += Rect::Overlap(boxes[i], boxes[(i + 1) % count]);
+        }
+    }
+    Bench::Report("micro", scenario, "rect_overlap", rectTimer.Milliseconds() * 1e6 / (microRepeats * count), "ns/test");
+
+    Bench::Timer levelTimer;
+    for (int r = 0; r < microRepeats; r++)
+    {
+        for (auto& box : boxes)
+        {
+            hits += level.Overlap(box).has_value();
+        }
+    }
+    Bench::Report("micro", scenario, "level_overlap", levelTimer.Milliseconds() * 1e6 / (microRepeats * count), "ns/query");
+
+    tako::World world;
+    std::vector<tako::Entity> bodies;
+    for (size_t i = 0; i < count; i++)
+    {
+        auto entity = world.Create<Position, RigidBody>();
+        auto& pos = world.GetComponent<Position>(entity);
+        pos.x = boxes[i].x;
+        pos.y = boxes[i].y;
+        auto& rigid = world.GetComponent<RigidBody>(entity);
+        rigid.size = {12, 12};
+        rigid.entity = entity;
+        rigid.tags = i % 2 ? BodyTag::Enemy : BodyTag::Carrot;
+        rigid.collidesWith = 0;
+        bodies.push_back(entity);
+    }
+
+    Bench::Timer groundedTimer;
+    for (int r = 0; r < microRepeats; r++)
+    {
+        for (auto entity : bodies)
+        {
+            hits += Physics::IsGrounded(&level, world.GetComponent<Position>(entity), world.GetComponent<RigidBody>(entity));
+        }
+    }
+    Bench::Report("micro", scenario, "is_grounded", groundedTimer.Milliseconds() * 1e6 / (microRepeats * count), "ns/body");
+
+    BodyBatch scratch;
+    Bench::Timer moveTimer;
+    for (auto entity : bodies)
+    {
+        Physics::Move(world, scratch, &level, world.GetComponent<Position>(entity), world.GetComponent<RigidBody>(entity), {0.5f, -2.5f});
+    }
+    Bench::Report("micro", scenario, "move_level", moveTimer.Milliseconds() * 1e6 / count, "ns/body");
+
+    // Movers test against every body in the world, so only a fixed number of them moves
+    size_t movers = std::min<size_t>(microMovers, count);
+    Bench::Timer pairTimer;
+    for (size_t i = 0; i < movers; i++)
+    {
+        auto& rigid = world.GetComponent<RigidBody>(bodies[i]);
+        rigid.collidesWith = BodyTag::Carrot;
+        Physics::Move(world, scratch, &level, world.GetComponent<Position>(bodies[i]), rigid, {0.5f, -2.5f}, {},
+            [&](auto& otherRigid, auto& movement)
+            {
+                hits++;
+            }
+        );
+        rigid.collidesWith = 0;
+    }
+    Bench::Report("micro", scenario, "move_bodies", pairTimer.Milliseconds() * 1e3 / movers, "us/mover");
+
+    NullDrawer drawer;
+    Bench::Timer screenTimer;
+    for (int r = 0; r < microRepeats; r++)
+    {
+        level.Draw(&drawer, {boxes[0].Position(), {240, 135}});
+    }
+    Bench::Report("micro", scenario, "draw_level_screen", screenTimer.Milliseconds() / microRepeats, "ms");
+    Bench::Keep(hits + drawer.calls);
+    Bench::Keep(drawer.area);
+}
+
+void RunGameMicro(const std::string& levelStr, size_t count)
+{
+    auto scenario = std::to_string(count);
+    auto game = std::make_unique<Game>();
+    game->StartGame(7, levelStr, false);
+    PlayerInput idle = 0;
+    game->Step(&idle, 1);
+
+    Bench::Timer spawnTimer;
+    game->SpawnParticles({200, 100}, count, -20, 20, -10, 50);
+    Bench::Report("micro", scenario, "spawn_particles", spawnTimer.Milliseconds() * 1e6 / count, "ns/particle");
+
+    Bench::Timer publishTimer;
+    for (int r = 0; r < microRepeats; r++)
+    {
+        game->PublishRenderFrame();
+    }
+    Bench::Report("micro", scenario, "build_render_list", publishTimer.Milliseconds() / microRepeats, "ms");
+
+    NullDrawer drawer;
+    game->ReadRenderFrame([&](const RenderFrame& frame)
+    {
+        Bench::Timer submitTimer;
+        for (int r = 0; r < microRepeats; r++)
+        {
+            SubmitRenderItems(&drawer, frame.items);
+        }
+        auto items = std::max<size_t>(1, frame.items.size());
+        Bench::Report("micro", scenario, "render_items", frame.items.size(), "count");
+        Bench::Report("micro", scenario, "submit_render_list", submitTimer.Milliseconds() * 1e6 / (microRepeats * items), "ns/item");
+    });
+    Bench::Keep(drawer.area);
+}
+
+// One rabbit per spawner on a level wide enough that most of them are out of the player's view, stepped at full
+// rate and with the simulation LOD. Rabbits wait two seconds before their first hop, the steps cover a few hops.
+// The cost per rabbit across the counts shows how the step scales
+void RunEnemyMicro(size_t count)
+{
+    std::array<double, 2> averages;
+    auto scenario = std::to_string(count);
+    auto levelStr = GenerateLevel({(int) count * 2 + 50, 13, (int) count, 30, 5});
+    auto rabbits = [](Game& game)
+    {
+        SimulationState state;
+        game.SaveState(state);
+        return state.world.Saved<Enemy>().size();
+    };
+    for (bool lod : {false, true})
+    {
+        std::string mode = lod ? "lod" : "full";
+        auto game = std::make_unique<Game>();
+        game->SetSimulationLod(lod);
+        game->StartGame(11, levelStr, false);
+        PlayerInput idle = 0;
+        // Spawners start out due, the first step brings in all rabbits
+        game->Step(&idle, 1);
+        Bench::Report("micro", scenario, "enemies", rabbits(*game), "count");
+        double maxStep = 0;
+        Bench::Timer timer;
+        for (int i = 0; i < microEnemySteps; i++)
+        {
+            Bench::Timer stepTimer;
+            game->Step(&idle, 1);
+            maxStep = std::max(maxStep, stepTimer.Milliseconds());
+        }
+        averages[lod] = timer.Milliseconds() / microEnemySteps;
+        Bench::Report("micro", scenario, "enemy_step_avg_" + mode, averages[lod], "ms");
+        Bench::Report("micro", scenario, "enemy_step_max_" + mode, maxStep, "ms");
+        Bench::Report("micro", scenario, "enemy_step_per_enemy_" + mode, averages[lod] * 1e3 / count, "us");
+    }
+    Bench::Report("micro", scenario, "enemy_step_lod_vs_full", averages[1] / averages[0], "x");
+}
+
+// What the rabbits did to the carrot, steps count from the start of the game
+struct EnemyOutcome
+{
+    int hits = 0;
+    float damage = 0;
+    int firstHit = -1;
+    int carrotLost = -1;
+};
+
+// Plays until the rabbits have taken the carrot down, watching its health after every step
+EnemyOutcome PlayEnemyOutcome(const std::string& levelStr, bool lod)
+{
+    auto game = std::make_unique<Game>();
+    game->SetSimulationLod(lod);
+    game->StartGame(11, levelStr, false);
+    PlayerInput idle = 0;
+    EnemyOutcome outcome;
+    SimulationState state;
+    float health = -1;
+    for (int step = 1; step <= microEnemyOutcomeSteps; step++)
+    {
+        game->Step(&idle, 1);
+        game->SaveState(state);
+        auto& carrots = state.world.Saved<Carrot>();
+        if (carrots.empty())
+        {
+            outcome.carrotLost = step;
+            break;
+        }
+        float now = carrots.front().second.health;
+        if (health >= 0 && now < health)
+        {
+            outcome.hits++;
+            outcome.damage += health - now;
+            if (outcome.firstHit < 0)
+            {
+                outcome.firstHit = step;
+            }
+        }
+        health = now;
+    }
+    return outcome;
+}
+
+// The LOD has to leave the game playing out the same. Nobody throws turnips, so the carrot is the only thing the
+// rabbits can change: how hard and when they hit it has to match full rate up to the time a sliced rabbit may lag
+void RunEnemyOutcomeMicro(size_t count)
+{
+    auto scenario = std::to_string(count);
+    auto levelStr = GenerateLevel({(int) count * 2 + 50, 13, (int) count, 30, 5});
+    EnemyOutcome outcomes[2];
+    for (bool lod : {false, true})
+    {
+        std::string mode = lod ? "lod" : "full";
+        auto& outcome = outcomes[lod];
+        outcome = PlayEnemyOutcome(levelStr, lod);
+        Bench::Report("micro", scenario, "carrot_hits_" + mode, outcome.hits, "count");
+        Bench::Report("micro", scenario, "carrot_damage_" + mode, outcome.damage, "hp");
+        Bench::Report("micro", scenario, "carrot_first_hit_" + mode, outcome.firstHit, "steps");
+        Bench::Report("micro", scenario, "carrot_lost_" + mode, outcome.carrotLost, "steps");
+    }
+    auto& full = outcomes[0];
+    auto& lod = outcomes[1];
+    Bench::Check(full.carrotLost > 0 && lod.carrotLost > 0, "micro", scenario, "rabbits take the carrot down");
+    Bench::Check(std::abs(full.hits - lod.hits) <= 1, "micro", scenario, "carrot hits match full rate");
+    Bench::Check(std::abs(full.damage - lod.damage) <= 0.1f * full.damage, "micro", scenario, "carrot damage matches full rate");
+    Bench::Check(std::abs(full.firstHit - lod.firstHit) <= microEnemyOutcomeSlack, "micro", scenario, "first hit matches full rate");
+    Bench::Check(std::abs(full.carrotLost - lod.carrotLost) <= microEnemyOutcomeSlack, "micro", scenario, "carrot lost matches full rate");
+}
+
+// Hot paths in isolation at 1k to 100k entities, on a small and a huge generated level
+void RunMicroScenarios()
+{
+    auto small = GenerateLevel({47, 13, 4, 30, 1});
+    auto huge = GenerateLevel({10000, 1000, 2000, 20000, 3});
+    for (size_t count : {1000, 10000, 100000})
+    {
+        RunLevelMicro("small", small, count);
+        RunLevelMicro("huge", huge, count);
+        RunGameMicro(small, count);
+    }
+    for (size_t count : {100, 1000, 10000})
+    {
+        RunEnemyMicro(count);
+    }
+    RunEnemyOutcomeMicro(100);
+}
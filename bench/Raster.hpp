@@ -0,0 +1,214 @@
+#pragma once
+#include "Bench.hpp"
+#include "SoftwareDrawer.hpp"
+#include "Random.hpp"
+#include "LevelGenerator.hpp"
+#include "Game.hpp"
+#include "RenderList.hpp"
+#include <string>
+#include <vector>
+
+namespace
+{
+    constexpr auto rasterFrames = 200;
+    // Steps the golden game plays before its frame is captured, early enough that no rabbit reached the carrot yet
+    constexpr auto rasterGameFrames = 120;
+    // FNV-1a of the game frame rendered by DrawGameFrame, update it together with any intended change to the output
+    constexpr tako::U32 rasterGoldenChecksum = 1863586097u;
+}
+
+tako::U32 FrameChecksum(const SoftwareDrawer& drawer)
+{
+    tako::U32 hash = 2166136261u;
+    auto bytes = reinterpret_cast<const tako::U8*>(drawer.Pixels());
+    for (size_t i = 0; i < size_t(drawer.Width()) * drawer.Height() * sizeof(tako::Color); i++)
+    {
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+    return hash;
+}
+
+// Procedural stand-ins for the tileset and the character sheet: opaque tiles, sprites with transparent borders
+struct RasterAssets
+{
+    std::vector<SoftwareDrawer::Sprite*> tiles;
+    std::vector<SoftwareDrawer::Sprite*> sprites;
+    SoftwareDrawer::Texture* hud;
+};
+
+RasterAssets CreateRasterAssets(SoftwareDrawer& drawer)
+{
+    RasterAssets assets;
+    std::vector<tako::Color> tileset(64 * 16);
+    for (int y = 0; y < 16; y++)
+    {
+        for (int x = 0; x < 64; x++)
+        {
+            tako::U8 shade = 60 + (x / 16) * 40 + ((x ^ y) & 3) * 8;
+            tileset[y * 64 + x] = {shade, tako::U8(shade / 2), tako::U8(255 - shade), 255};
+        }
+    }
+    auto tileTexture = drawer.CreateTexture(tileset.data(), 64, 16);
+    for (int i = 0; i < 4; i++)
+    {
+        assets.tiles.push_back(drawer.CreateSprite(tileTexture, i * 16, 0, 16, 16));
+    }
+
+    std::vector<tako::Color> sheet(48 * 12);
+    for (int y = 0; y < 12; y++)
+    {
+        for (int x = 0; x < 48; x++)
+        {
+            int local = x % 12;
+            bool inside = local > 1 && local < 10 && y > 1 && y < 11;
+            sheet[y * 48 + x] = inside ? tako::Color{tako::U8(200 + local * 5), tako::U8(x * 5), tako::U8(y * 20), 255} : tako::Color{0, 0, 0, 0};
+        }
+    }
+    auto sheetTexture = drawer.CreateTexture(sheet.data(), 48, 12);
+    for (int i = 0; i < 4; i++)
+    {
+        assets.sprites.push_back(drawer.CreateSprite(sheetTexture, i * 12, 0, 12, 12));
+        assets.sprites.push_back(drawer.CreateSprite(sheetTexture, (i + 1) * 12, 0, -12, 12));
+    }
+
+    std::vector<tako::Color> hud(240 * 24, {255, 255, 255, 0});
+    for (int x = 14; x < 46; x++)
+    {
+        for (int y = 4; y < 12; y++)
+        {
+            hud[y * 240 + x] = {255, 255, 255, 255};
+        }
+    }
+    assets.hud = drawer.CreateTexture(hud.data(), 240, 24);
+    return assets;
+}
+
+// A frame shaped like gameplay: a screen of tiles, characters facing both ways, particles, the HUD and a translucent overlay
+void DrawRasterScene(SoftwareDrawer& drawer, RasterAssets& assets, int frame)
+{
+    auto size = drawer.GetCameraViewSize();
+    tako::Vector2 camera(400 + frame % 64, 120);
+    drawer.Clear();
+    drawer.SetCameraPosition(camera);
+    for (int ty = 0; ty < 16; ty++)
+    {
+        for (int tx = 20; tx < 40; tx++)
+        {
+            if ((tx * 7 + ty * 3) % 5 < 2)
+            {
+                drawer.DrawSprite(tx * 16, ty * 16 + 16, 16, 16, assets.tiles[(tx + ty) % 4]);
+            }
+        }
+    }
+    Random random;
+    random.Seed(frame + 1);
+    for (int i = 0; i < 200; i++)
+    {
+        drawer.DrawSprite(camera.x - 130 + random.Int(260), camera.y - 75 + random.Int(150), 12, 12, assets.sprites[i % assets.sprites.size()]);
+    }
+    for (int i = 0; i < 1000; i++)
+    {
+        drawer.DrawRectangle(camera.x - 120 + random.Int(240), camera.y - 68 + random.Int(136), 1, 1, {255, 255, 255, 255});
+    }
+    drawer.SetCameraPosition(size / 2);
+    drawer.DrawImage(0, size.y, 240, 24, assets.hud);
+    drawer.DrawRectangle(0, size.y / 2, size.x, size.y / 2, {0, 0, 0, 160});
+    drawer.Present();
+}
+
+// Hands the calls of the render list to the CPU drawer, whose sprites the items carry in place of tako's
+struct SoftwareSubmitter
+{
+    SoftwareDrawer& drawer;
+
+    void DrawSprite(float x, float y, float w, float h, tako::Sprite* sprite)
+    {
+        drawer.DrawSprite(x, y, w, h, reinterpret_cast<SoftwareDrawer::Sprite*>(sprite));
+    }
+
+    void DrawRectangle(float x, float y, float w, float h, tako::Color color)
+    {
+        drawer.DrawRectangle(x, y, w, h, color);
+    }
+};
+
+// A headless game loads no assets, every item it draws with a sprite gets a stand-in: tiles by where they are,
+// the rest by size
+void SubmitWithStandIns(SoftwareSubmitter& submitter, RasterAssets& assets, const std::vector<RenderItem>& items, std::vector<RenderItem>& scratch)
+{
+    scratch = items;
+    for (auto& item : scratch)
+    {
+        if (item.layer == RenderLayer::Rectangles)
+        {
+            continue;
+        }
+        auto standIn = item.layer == RenderLayer::Tiles
+            ? assets.tiles[int(item.position.x / 16 + item.position.y / 16) % assets.tiles.size()]
+            : assets.sprites[int(item.size.x + item.size.y) % assets.sprites.size()];
+        item.sprite = reinterpret_cast<tako::Sprite*>(standIn);
+    }
+    SubmitRenderItems(&submitter, scratch);
+}
+
+// The level and render list of a published frame, submitted the way Game::DrawFrame does
+void DrawGameFrame(SoftwareDrawer& drawer, RasterAssets& assets, const RenderFrame& frame)
+{
+    SoftwareSubmitter submitter{drawer};
+    std::vector<RenderItem> scratch;
+    drawer.Clear();
+    drawer.SetCameraPosition(frame.camera);
+    SubmitWithStandIns(submitter, assets, frame.tiles, scratch);
+    SubmitWithStandIns(submitter, assets, frame.items, scratch);
+    drawer.Present();
+}
+
+// Frames per second of the CPU drawer at the game resolution for a busy scene and a game frame, and a check that every thread count renders the golden
+// frame of a real game
+void RunRasterScenarios(const char* dumpFile)
+{
+    auto game = std::make_unique<Game>();
+    game->StartGame(7, GenerateLevel({47, 13, 4, 30, 1}), false);
+    InputLatency::Clock::time_point start;
+    for (int frame = 0; frame < rasterGameFrames; frame++)
+    {
+        game->Simulate(0, 1.0f / 60, start);
+    }
+    game->PublishRenderFrame();
+    RenderFrame gameFrame;
+    game->ReadRenderFrame([&](const RenderFrame& frame)
+    {
+        gameFrame = frame;
+    });
+    Bench::Check(!gameFrame.tiles.empty() && !gameFrame.items.empty(), "raster", "game", "frame has tiles and items");
+
+    for (int threads : {1, 2, 4})
+    {
+        SoftwareDrawer drawer(threads);
+        drawer.SetTargetSize(gameFrame.viewSize.x, gameFrame.viewSize.y);
+        auto assets = CreateRasterAssets(drawer);
+        Bench::Timer timer;
+        for (int frame = 0; frame < rasterFrames; frame++)
+        {
+            DrawRasterScene(drawer, assets, frame);
+        }
+        auto elapsed = timer.Milliseconds();
+        auto scenario = std::to_string(threads) + "_threads";
+        Bench::Report("raster", scenario, "fps", rasterFrames * 1000 / elapsed, "frames/s");
+        Bench::Timer gameTimer;
+        for (int frame = 0; frame < rasterFrames; frame++)
+        {
+            DrawGameFrame(drawer, assets, gameFrame);
+        }
+        Bench::Report("raster", scenario, "fps_game", rasterFrames * 1000 / gameTimer.Milliseconds(), "frames/s");
+
+        DrawGameFrame(drawer, assets, gameFrame);
+        auto checksum = FrameChecksum(drawer);
+        Bench::Report("raster", scenario, "checksum", checksum, "fnv");
+        Bench::Check(checksum == rasterGoldenChecksum, "raster", scenario, "golden frame");
+        if (dumpFile && threads == 1)
+        {
+            drawer.WritePpm(dumpFile);
+        }
+    }
+}
@@ -0,0 +1,106 @@
+#pragma once
+#include "Tako.hpp"
+#include "Renderer.hpp"
+#include <vector>
+#include <initializer_list>
+#include <string_view>
+
+struct ClipFrame
+{
+    float x, y, w, h;
+    float duration;
+};
+
+// Clip definitions over sprite sheets. The frames of every clip sit in one array and every frame exists as a sprite
+// twice, once as drawn and once mirrored, so an AnimatedSprite only needs a clip, a frame index and a flip bit
+class AnimationSet
+{
+public:
+    // A looping clip starts over after its last frame, the others hold it. Clips that don't mirror ignore the flip bit
+    void Define(tako::U8 clip, const char* sheet, std::initializer_list<ClipFrame> frames, bool loop = false, bool mirrors = true)
+    {
+        if (clip >= m_clips.size())
+        {
+            m_clips.resize(clip + 1);
+        }
+        m_clips[clip] = {sheet, (int) m_frames.size(), (int) frames.size(), loop, mirrors};
+        m_frames.insert(m_frames.end(), frames);
+        m_sprites.resize(m_frames.size() * 2, nullptr);
+    }
+
+    // Hands out the sprite slots a sheet fills in, with the region to cut for each of them
+    template<typename Visit>
+    void ForEachSlot(const char* sheet, Visit visit)
+    {
+        for (auto& clip : m_clips)
+        {
+            if (!clip.sheet || std::string_view(clip.sheet) != sheet)
+            {
+                continue;
+            }
+            for (int i = clip.first; i < clip.first + clip.count; i++)
+            {
+                auto& frame = m_frames[i];
+                visit(&m_sprites[i * 2], frame.x, frame.y, frame.w, frame.h);
+                visit(&m_sprites[i * 2 + 1], frame.x + frame.w, frame.y, -frame.w, frame.h);
+            }
+        }
+    }
+
+    void Play(AnimatedSprite& animation, tako::U8 clip)
+    {
+        if (animation.clip != clip)
+        {
+            animation.clip = clip;
+            animation.frame = 0;
+            animation.time = 0;
+        }
+    }
+
+    void Advance(AnimatedSprite& animation, float dt)
+    {
+        auto& clip = m_clips[animation.clip];
+        animation.time += dt;
+        while (true)
+        {
+            float duration = m_frames[clip.first + animation.frame].duration;
+            if (duration <= 0 || animation.time < duration)
+            {
+                return;
+            }
+            if (animation.frame + 1 < clip.count)
+            {
+                animation.frame++;
+            }
+            else if (clip.loop)
+            {
+                animation.frame = 0;
+            }
+            else
+            {
+                return;
+            }
+            animation.time -= duration;
+        }
+    }
+
+    tako::Sprite* Sprite(const AnimatedSprite& animation)
+    {
+        auto& clip = m_clips[animation.clip];
+        return m_sprites[(clip.first + animation.frame) * 2 + (animation.flip && clip.mirrors)];
+    }
+
+private:
+    struct Clip
+    {
+        const char* sheet;
+        int first;
+        int count;
+        bool loop;
+        bool mirrors;
+    };
+
+    std::vector<Clip> m_clips;
+    std::vector<ClipFrame> m_frames;
+    std::vector<tako::Sprite*> m_sprites;
+};
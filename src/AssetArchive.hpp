@@ -0,0 +1,313 @@
+#pragma once
+#include "Tako.hpp"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#ifdef __linux__
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// Layout of the archive written by ld46_pack: a header, the entries sorted by path, the path strings and then
+// the data of every entry aligned to 16 bytes. Offsets are from the start of the file
+namespace AssetPack
+{
+    constexpr char magic[8] = {'L', 'D', '4', '6', 'P', 'A', 'C', 'K'};
+    constexpr tako::U32 version = 1;
+    constexpr size_t dataAlignment = 16;
+
+    enum class Kind : tako::U16
+    {
+        Raw,
+        // Decoded RGBA8, width * height * 4 bytes
+        Image
+    };
+
+    enum class Compression : tako::U16
+    {
+        None,
+        Lz
+    };
+
+    struct Header
+    {
+        char magic[8];
+        tako::U32 version;
+        tako::U32 count;
+    };
+
+    struct Entry
+    {
+        tako::U32 pathOffset;
+        tako::U32 pathLength;
+        tako::U64 offset;
+        tako::U64 size;
+        tako::U64 rawSize;
+        Kind kind;
+        Compression compression;
+        tako::U32 width;
+        tako::U32 height;
+        tako::U32 reserved;
+    };
+    static_assert(sizeof(Entry) == 48, "Entries are read straight from the file");
+
+    // LZ77 with byte aligned sequences: a token with the literal count in the high and the match length minus 4
+    // in the low nibble, 15 in either continues the count in following bytes, then the literals and a 16 bit offset.
+    // The last sequence has literals only
+    bool Decompress(const tako::U8* src, size_t srcSize, tako::U8* dst, size_t dstSize)
+    {
+        auto srcEnd = src + srcSize;
+        auto dstStart = dst;
+        auto dstEnd = dst + dstSize;
+        auto length = [&](size_t value)
+        {
+            if (value != 15)
+            {
+                return value;
+            }
+            tako::U8 more;
+            do
+            {
+                if (src == srcEnd)
+                {
+                    return size_t(-1);
+                }
+                more = *src++;
+                value += more;
+            } while (more == 255);
+            return value;
+        };
+        while (src < srcEnd)
+        {
+            tako::U8 token = *src++;
+            size_t literals = length(token >> 4);
+            if (literals > size_t(srcEnd - src) || literals > size_t(dstEnd - dst))
+            {
+                return false;
+            }
+            memcpy(dst, src, literals);
+            src += literals;
+            dst += literals;
+            if (src == srcEnd)
+            {
+                break;
+            }
+            if (srcEnd - src < 2)
+            {
+                return false;
+            }
+            size_t offset = src[0] | (src[1] << 8);
+            src += 2;
+            size_t match = length(token & 15);
+            if (match == size_t(-1) || offset == 0 || offset > size_t(dst - dstStart) || match + 4 > size_t(dstEnd - dst))
+            {
+                return false;
+            }
+            match += 4;
+            // Byte by byte, matches may overlap what they produce
+            for (size_t i = 0; i < match; i++, dst++)
+            {
+                *dst = *(dst - offset);
+            }
+        }
+        return dst == dstEnd;
+    }
+}
+
+struct AssetView
+{
+    AssetPack::Kind kind;
+    int width;
+    int height;
+    std::string_view data;
+};
+
+// Read only access to a packed archive. The file is mapped as a whole, uncompressed entries are served as views
+// into the mapping and compressed ones are unpacked on first use and kept for the lifetime of the archive
+class AssetArchive
+{
+public:
+    AssetArchive() = default;
+    AssetArchive(const AssetArchive&) = delete;
+    AssetArchive& operator=(const AssetArchive&) = delete;
+
+    ~AssetArchive()
+    {
+        Close();
+    }
+
+    bool Open(const char* file)
+    {
+        Close();
+#ifdef __linux__
+        int fd = open(file, O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+        {
+            return false;
+        }
+        struct stat info;
+        if (fstat(fd, &info) != 0 || info.st_size < (off_t) sizeof(AssetPack::Header))
+        {
+            close(fd);
+            return false;
+        }
+        void* mapping = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (mapping == MAP_FAILED)
+        {
+            return false;
+        }
+        m_data = static_cast<const tako::U8*>(mapping);
+        m_size = info.st_size;
+        m_mapped = true;
+#else
+        std::ifstream stream(file, std::ios::binary | std::ios::ate);
+        if (!stream)
+        {
+            return false;
+        }
+        m_buffer.resize(stream.tellg());
+        stream.seekg(0);
+        stream.read(reinterpret_cast<char*>(m_buffer.data()), m_buffer.size());
+        m_data = m_buffer.data();
+        m_size = m_buffer.size();
+#endif
+        if (!Validate())
+        {
+            Close();
+            return false;
+        }
+        return true;
+    }
+
+    void Close()
+    {
+#ifdef __linux__
+        if (m_mapped)
+        {
+            munmap(const_cast<tako::U8*>(m_data), m_size);
+        }
+#endif
+        m_mapped = false;
+        m_data = nullptr;
+        m_size = 0;
+        m_entries = nullptr;
+        m_count = 0;
+        m_buffer.clear();
+        m_unpacked.clear();
+    }
+
+    bool IsOpen() const
+    {
+        return m_entries;
+    }
+
+    size_t Count() const
+    {
+        return m_count;
+    }
+
+    // Paths are the ones the game loads loose files with, "/Player.png"
+    std::optional<AssetView> Find(std::string_view path)
+    {
+        auto end = m_entries + m_count;
+        auto entry = std::lower_bound(m_entries, end, path, [&](const AssetPack::Entry& e, std::string_view p)
+        {
+            return Path(e) < p;
+        });
+        if (entry == end || Path(*entry) != path)
+        {
+            return std::nullopt;
+        }
+        std::string_view data(reinterpret_cast<const char*>(m_data + entry->offset), entry->size);
+        if (entry->compression == AssetPack::Compression::Lz)
+        {
+            auto& unpacked = m_unpacked[entry - m_entries];
+            if (unpacked.empty() && entry->rawSize > 0)
+            {
+                unpacked.resize(entry->rawSize);
+                if (!AssetPack::Decompress(m_data + entry->offset, entry->size, unpacked.data(), unpacked.size()))
+                {
+                    LOG_ERR("Corrupt archive entry {}", path);
+                    unpacked.clear();
+                    return std::nullopt;
+                }
+            }
+            data = {reinterpret_cast<const char*>(unpacked.data()), unpacked.size()};
+        }
+        return AssetView{entry->kind, (int) entry->width, (int) entry->height, data};
+    }
+
+private:
+    std::string_view Path(const AssetPack::Entry& entry) const
+    {
+        return {reinterpret_cast<const char*>(m_data + entry.pathOffset), entry.pathLength};
+    }
+
+    bool Validate()
+    {
+        AssetPack::Header header;
+        if (m_size < sizeof(header))
+        {
+            return false;
+        }
+        memcpy(&header, m_data, sizeof(header));
+        if (memcmp(header.magic, AssetPack::magic, sizeof(header.magic)) != 0 || header.version != AssetPack::version ||
+            header.count > (m_size - sizeof(header)) / sizeof(AssetPack::Entry))
+        {
+            return false;
+        }
+        auto entries = reinterpret_cast<const AssetPack::Entry*>(m_data + sizeof(header));
+        for (tako::U32 i = 0; i < header.count; i++)
+        {
+            auto& entry = entries[i];
+            if (entry.pathOffset + tako::U64(entry.pathLength) > m_size || entry.offset > m_size || entry.size > m_size - entry.offset)
+            {
+                return false;
+            }
+            auto expected = entry.kind == AssetPack::Kind::Image ? tako::U64(entry.width) * entry.height * 4 : entry.rawSize;
+            if (entry.rawSize != expected || (entry.compression == AssetPack::Compression::None && entry.size != entry.rawSize))
+            {
+                return false;
+            }
+        }
+        m_entries = entries;
+        m_count = header.count;
+        return true;
+    }
+
+    const tako::U8* m_data = nullptr;
+    size_t m_size = 0;
+    bool m_mapped = false;
+    const AssetPack::Entry* m_entries = nullptr;
+    size_t m_count = 0;
+    std::vector<tako::U8> m_buffer;
+    std::unordered_map<size_t, std::vector<tako::U8>> m_unpacked;
+};
+
+// Bitmaps come pre-decoded from the archive when it has them, otherwise the loose file is decoded
+tako::Bitmap LoadBitmap(AssetArchive& archive, const char* file)
+{
+    auto view = archive.Find(file);
+    if (!view || view->kind != AssetPack::Kind::Image)
+    {
+        return tako::Bitmap::FromFile(file);
+    }
+    tako::Bitmap bitmap(view->width, view->height);
+    auto pixels = reinterpret_cast<const tako::U8*>(view->data.data());
+    for (int y = 0; y < view->height; y++)
+    {
+        for (int x = 0; x < view->width; x++)
+        {
+            auto pixel = pixels + (y * view->width + x) * 4;
+            bitmap.SetPixel(x, y, {pixel[0], pixel[1], pixel[2], pixel[3]});
+        }
+    }
+    return bitmap;
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <algorithm>
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <limits.h>
+#endif
+
+// Reports the names of files in a directory that were written since the last poll, without blocking
+class AssetWatcher
+{
+public:
+    ~AssetWatcher()
+    {
+#ifdef __linux__
+        if (m_fd >= 0)
+        {
+            close(m_fd);
+        }
+#endif
+    }
+
+    bool Watch(const char* directory)
+    {
+#ifdef __linux__
+        m_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (m_fd < 0)
+        {
+            return false;
+        }
+        if (inotify_add_watch(m_fd, directory, IN_CLOSE_WRITE | IN_MOVED_TO) < 0)
+        {
+            close(m_fd);
+            m_fd = -1;
+            return false;
+        }
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    const std::vector<std::string>& Poll()
+    {
+        m_changed.clear();
+#ifdef __linux__
+        if (m_fd < 0)
+        {
+            return m_changed;
+        }
+        alignas(inotify_event) char buffer[4096];
+        ssize_t length;
+        while ((length = read(m_fd, buffer, sizeof(buffer))) > 0)
+        {
+            for (char* ptr = buffer; ptr < buffer + length;)
+            {
+                auto event = reinterpret_cast<inotify_event*>(ptr);
+                if (event->len > 0)
+                {
+                    std::string name(event->name);
+                    if (std::find(m_changed.begin(), m_changed.end(), name) == m_changed.end())
+                    {
+                        m_changed.push_back(name);
+                    }
+                }
+                ptr += sizeof(inotify_event) + event->len;
+            }
+        }
+#endif
+        return m_changed;
+    }
+
+private:
+    int m_fd = -1;
+    std::vector<std::string> m_changed;
+};
@@ -0,0 +1,104 @@
+#pragma once
+#include "Tako.hpp"
+#include "World.hpp"
+#include <array>
+#include <algorithm>
+#include <tuple>
+#include <type_traits>
+
+// One number per listed component type, used for live counts, peaks and capacity hints alike
+template<typename... Components>
+class ComponentCounts
+{
+public:
+    template<typename T>
+    size_t Get() const
+    {
+        return m_counts[Index<T>()];
+    }
+
+    template<typename T>
+    void Set(size_t count)
+    {
+        m_counts[Index<T>()] = count;
+    }
+
+    void Raise(const ComponentCounts& other)
+    {
+        for (size_t i = 0; i < m_counts.size(); i++)
+        {
+            m_counts[i] = std::max(m_counts[i], other.m_counts[i]);
+        }
+    }
+
+    // Visits a default constructed component of every type with its count, in the listed order
+    template<typename Visit>
+    void ForEach(Visit visit) const
+    {
+        size_t i = 0;
+        (visit(Components{}, m_counts[i++]), ...);
+    }
+
+private:
+    template<typename T, size_t I = 0>
+    static constexpr size_t Index()
+    {
+        static_assert(I < sizeof...(Components), "Component is not counted");
+        if constexpr (std::is_same_v<T, std::tuple_element_t<I, std::tuple<Components...>>>)
+        {
+            return I;
+        }
+        else
+        {
+            return Index<T, I + 1>();
+        }
+    }
+
+    std::array<size_t, sizeof...(Components)> m_counts = {};
+};
+
+// Live count and high-water mark of every component type in a world. Taking a census walks all pools, the game
+// only does it after steps that created entities since the peak can't rise otherwise
+template<typename... Components>
+class ComponentCensus
+{
+public:
+    using Counts = ComponentCounts<Components...>;
+
+    void Take(tako::World& world)
+    {
+        (Count<Components>(world), ...);
+        m_highWater.Raise(m_live);
+    }
+
+    const Counts& Live() const
+    {
+        return m_live;
+    }
+
+    const Counts& HighWater() const
+    {
+        return m_highWater;
+    }
+
+    void Reset()
+    {
+        m_live = {};
+        m_highWater = {};
+    }
+
+private:
+    template<typename T>
+    void Count(tako::World& world)
+    {
+        size_t count = 0;
+        world.template IterateComps<T>([&](T&)
+        {
+            count++;
+        });
+        m_live.template Set<T>(count);
+    }
+
+    Counts m_live;
+    Counts m_highWater;
+};
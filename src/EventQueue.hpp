@@ -0,0 +1,62 @@
+#pragma once
+#include <vector>
+#include <tuple>
+
+// Events of the listed types, kept in one buffer per producing thread so emitting never needs a lock.
+// Consumers read the buffers in thread order once the producers are done, so the order never depends on scheduling
+template<typename... Events>
+class EventQueue
+{
+public:
+    class Buffer
+    {
+    public:
+        template<typename T>
+        void Emit(const T& event)
+        {
+            std::get<std::vector<T>>(m_events).push_back(event);
+        }
+
+    private:
+        friend class EventQueue;
+        std::tuple<std::vector<Events>...> m_events;
+    };
+
+    EventQueue(int threads = 1) : m_buffers(threads)
+    {
+    }
+
+    Buffer& Writer(int thread = 0)
+    {
+        return m_buffers[thread];
+    }
+
+    // Room for that many events of one type in every buffer, so bursts up to it don't grow them mid step
+    template<typename T>
+    void Reserve(size_t count)
+    {
+        for (auto& buffer : m_buffers)
+        {
+            std::get<std::vector<T>>(buffer.m_events).reserve(count);
+        }
+    }
+
+    // Hands every pending event of one type to the consumer and drops them, events the consumer emits itself are included
+    template<typename T, typename Consumer>
+    void Consume(Consumer consumer)
+    {
+        for (auto& buffer : m_buffers)
+        {
+            auto& events = std::get<std::vector<T>>(buffer.m_events);
+            for (size_t i = 0; i < events.size(); i++)
+            {
+                T event = events[i];
+                consumer(event);
+            }
+            events.clear();
+        }
+    }
+
+private:
+    std::vector<Buffer> m_buffers;
+};
@@ -0,0 +1,59 @@
+#pragma once
+#include <memory_resource>
+#include <cstddef>
+#include <memory>
+#include <cassert>
+
+namespace
+{
+    constexpr auto frameArenaSize = 256 * 1024;
+}
+
+// Bump allocator for data that only lives until the next frame, everything is released at once by Reset.
+// Requests that don't fit anymore go to the heap and are released on the next Reset as well
+class FrameArena : public std::pmr::memory_resource
+{
+public:
+    FrameArena(size_t capacity = frameArenaSize) : m_buffer(new std::byte[capacity]), m_capacity(capacity)
+    {
+    }
+
+    void Reset()
+    {
+        m_used = 0;
+        m_overflow.release();
+    }
+
+    size_t Used() const
+    {
+        return m_used;
+    }
+
+private:
+    // Offsets are aligned within the buffer, which new only aligns for the fundamental types
+    void* do_allocate(size_t bytes, size_t alignment) override
+    {
+        assert(alignment <= alignof(std::max_align_t));
+        size_t start = (m_used + alignment - 1) & ~(alignment - 1);
+        if (start + bytes > m_capacity)
+        {
+            return m_overflow.allocate(bytes, alignment);
+        }
+        m_used = start + bytes;
+        return m_buffer.get() + start;
+    }
+
+    void do_deallocate(void* ptr, size_t bytes, size_t alignment) override
+    {
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+    {
+        return this == &other;
+    }
+
+    std::unique_ptr<std::byte[]> m_buffer;
+    size_t m_capacity;
+    size_t m_used = 0;
+    std::pmr::monotonic_buffer_resource m_overflow;
+};
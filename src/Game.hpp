@@ -6,12 +6,35 @@
 #include "Player.hpp"
 #include "Physics.hpp"
 #include "Level.hpp"
+#include "Navigation.hpp"
+#include "Streaming.hpp"
+#include "Sound.hpp"
+#include "AssetWatcher.hpp"
+#include "FrameArena.hpp"
+#include "Random.hpp"
+#include "WorldSnapshot.hpp"
+#include "EventQueue.hpp"
+#include "RenderList.hpp"
+#include "Hud.hpp"
+#include "Animation.hpp"
+#include "Prefab.hpp"
+#include "AssetArchive.hpp"
+#include "ResourceCache.hpp"
+#include "ComponentCensus.hpp"
+#include "TimerWheel.hpp"
+#include "InputLatency.hpp"
 #include "Font.hpp"
 #include <array>
 #include <time.h>
 #include <stdlib.h>
 #include <algorithm>
 #include <sstream>
+#include <fstream>
+#include <string>
+#include <charconv>
+#include <memory_resource>
+#include <memory>
+#include <atomic>
 
 tako::Vector2 FitMapBound(Rect bounds, tako::Vector2 cameraPos, tako::Vector2 camSize)
 {
@@ -29,9 +52,8 @@ struct Text
     tako::Vector2 size;
 };
 
-Text CreateText(tako::PixelArtDrawer* drawer, tako::Font* font, std::string_view text)
+Text CreateText(tako::PixelArtDrawer* drawer, const tako::Bitmap& bitmap)
 {
-    auto bitmap = font->RenderText(text, 1);
     auto texture = drawer->CreateTexture(bitmap);
     return
     {
@@ -40,8 +62,46 @@ Text CreateText(tako::PixelArtDrawer* drawer, tako::Font* font, std::string_view
     };
 }
 
+Text CreateText(tako::PixelArtDrawer* drawer, tako::Font* font, std::string_view text)
+{
+    return CreateText(drawer, font->RenderText(text, 1));
+}
+
+void AppendNumber(std::pmr::string& str, int value)
+{
+    char digits[16];
+    auto end = std::to_chars(digits, digits + sizeof(digits), value).ptr;
+    str.append(digits, end);
+}
+
+namespace
+{
+    constexpr auto simulationStep = 1.0f / 60;
+    constexpr auto maxStepsPerFrame = 4;
+    // Growth a plant needs to show each sprite stage, the last one is ripe
+    constexpr std::array<float, 3> plantStageGrowth = {0, 5, 10};
+    // Target size of the pixel art drawer, the camera view can be larger depending on the window
+    constexpr auto viewWidth = 240;
+    constexpr auto viewHeight = 135;
+    // Area around every player that is simulated at full rate and gets effects, the camera view plus a tile of margin.
+    // It is the same for all peers, the actual camera size is not
+    constexpr auto simulationViewWidth = viewWidth + 32;
+    constexpr auto simulationViewHeight = viewHeight + 32;
+    // Tiles are published a tile past the view on every side, a late latched camera sits slightly off the published one
+    constexpr auto publishedTileMargin = 16;
+    // Off view rabbits take turns, each one is stepped every few steps with the time it missed
+    constexpr auto enemyLodInterval = 4;
+    constexpr auto playerWalkSpeed = 64;
+    constexpr auto playerAcceleration = 0.2f;
+}
+
 struct Background {};
 struct Foreground {};
+// Rabbits near a player are stepped every step, the ones off every view only in their slice.
+// The tags keep each loop from visiting the other rabbits at all
+struct InView {};
+template<int Slice>
+struct OffView {};
 struct Carrot
 {
     float health;
@@ -57,21 +117,77 @@ enum GameState
     GameOver
 };
 
+enum AnimationClip : tako::U8
+{
+    PlayerIdle,
+    PlayerWalk,
+    PlayerJump,
+    RabbitIdle,
+    RabbitJump,
+    RabbitDead
+};
+
+// The clip table is part of the simulation and exists without assets, loading the sheets only fills in the sprites
+AnimationSet CreateAnimations()
+{
+    AnimationSet animations;
+    animations.Define(AnimationClip::PlayerIdle, "/Player.png", {{0, 0, 12, 12, 0}});
+    animations.Define(AnimationClip::PlayerWalk, "/Player.png", {{12, 0, 12, 12, 0.1f}, {24, 0, 12, 12, 0.1f}}, true);
+    animations.Define(AnimationClip::PlayerJump, "/Player.png", {{36, 0, 12, 12, 0}}, false, false);
+    animations.Define(AnimationClip::RabbitIdle, "/Rabbit.png", {{0, 0, 12, 12, 0}});
+    animations.Define(AnimationClip::RabbitJump, "/Rabbit.png", {{12, 0, 12, 12, 0}});
+    animations.Define(AnimationClip::RabbitDead, "/Rabbit.png", {{24, 0, 12, 12, 0}});
+    return animations;
+}
+
+enum class GameOverCause
+{
+    None,
+    Hunger,
+    Carrot
+};
+
+// Growth is never ticked, it follows from the step the plant was planted in. Stage changes are scheduled
+// on the game's plant timer wheel
 struct Plant
 {
-    float growth;
+    tako::U32 plantedAt;
     float growthRate;
+    TimerHandle stageTimer;
+
+    void Reset(Random& random, tako::U32 step)
+    {
+        plantedAt = step;
+        growthRate = random.Int(100) / 50.0f + 0.8f;
+    }
+
+    float Growth(tako::U32 step) const
+    {
+        return (step - plantedAt) * simulationStep * growthRate;
+    }
+
+    void SetGrowth(float growth, tako::U32 step)
+    {
+        plantedAt = step - tako::U32(growth / (simulationStep * growthRate) + 0.5f);
+    }
 
-    void Reset()
+    // Steps after planting from which a stage shows
+    tako::U32 StageSteps(int stage) const
     {
-        growth = 0;
-        growthRate = rand() % 100 / 50.0f + 0.8f;
+        return tako::U32(plantStageGrowth[stage] / (simulationStep * growthRate)) + 1;
+    }
+
+    int Stage(tako::U32 step) const
+    {
+        auto grown = step - plantedAt;
+        return grown >= StageSteps(2) ? 2 : grown >= StageSteps(1) ? 1 : 0;
     }
 };
 
 struct Temporary
 {
     float left;
+    tako::Entity entity;
 };
 
 struct Particle
@@ -89,6 +205,17 @@ struct Enemy
     tako::Vector2 speed;
     float groundTime;
     float direction;
+    // Step the rabbit was last stepped at, an off view one catches up on the steps since
+    tako::U32 steppedAt;
+    // Off view slice it is tagged with, -1 while in view
+    int lodSlice;
+};
+
+// Rabbit changing between the in view loop and an off view slice, slice -1 is in view
+struct LodMove
+{
+    tako::Entity entity;
+    int slice;
 };
 
 struct DeadEnemy
@@ -103,165 +230,732 @@ struct Spawner
     float duration;
 };
 
+// What the systems report during a step, the effects are applied once all of them ran
+struct Stepped
+{
+    tako::Vector2 position;
+    float direction;
+};
+
+struct Jumped {};
+
+struct Harvested
+{
+    tako::Entity player;
+    tako::Vector2 position;
+};
+
+struct Thrown {};
+
+struct Eaten
+{
+    tako::Vector2 position;
+};
+
+struct TurnipBroke
+{
+    tako::Vector2 position;
+    tako::Vector2 speed;
+    bool hitLevel;
+};
+
+struct Killed
+{
+    tako::Entity enemy;
+};
+
+struct Landed
+{
+    tako::Vector2 position;
+};
+
+struct Hopped
+{
+    tako::Vector2 position;
+    float direction;
+};
+
+struct CarrotHurt
+{
+    tako::Entity carrot;
+    tako::Vector2 position;
+    tako::Vector2 speed;
+};
+
+struct Died
+{
+    tako::Vector2 position;
+    GameOverCause cause;
+};
+
+// Everything Draw needs from the simulation, captured at the end of Update. It holds no pointers into the level
+// or the world, the next Update changes those while Draw is still reading
+struct RenderFrame
+{
+    GameState state = GameState::PressAny;
+    GameOverCause gameOverCause = GameOverCause::None;
+    tako::Vector2 camera;
+    tako::Vector2 viewSize;
+    Rect mapBounds;
+    float carrotHealth = 0;
+    float playerHunger = 0;
+    int score = 0;
+    // Bumped by every reload of an image, Draw rebuilds the textures it composed from them
+    tako::U32 assetVersion = 0;
+    std::vector<RenderItem> tiles;
+    std::vector<RenderItem> items;
+    // Last input edge the frame shows, and what a late latched draw needs to move the local player and camera again
+    tako::U32 inputSerial = 0;
+    int playerItem = -1;
+    // Sprite of the local player facing either way, indexed by the flip bit
+    std::array<tako::Sprite*, 2> playerSprites = {};
+    bool playerFlip = false;
+    float playerSpeed = 0;
+    float sinceStep = 0;
+    tako::Vector2 cameraFrom;
+    float cameraBlend = 0;
+};
+
+// Where a late latched draw puts the local player and the camera, the item is -1 without a latch
+struct LatchedView
+{
+    tako::Vector2 camera;
+    int item = -1;
+    RenderItem player;
+};
+
+using GameEvents = EventQueue<Stepped, Jumped, Harvested, Thrown, Eaten, TurnipBroke, Killed, Landed, Hopped, CarrotHurt, Died>;
+
+struct SpriteFrame
+{
+    tako::Sprite** sprite;
+    float x, y, w, h;
+};
+
+struct ImageAsset
+{
+    const char* file;
+    tako::Texture** texture;
+    std::vector<SpriteFrame> sprites;
+    Resource<tako::Texture> loaded;
+    std::vector<Resource<tako::Sprite>> frames;
+};
+
+struct ClipAsset
+{
+    const char* file;
+    tako::AudioClip** clip;
+    SoundSettings settings;
+    Resource<tako::AudioClip> loaded;
+};
+
+template<template<typename...> class Holder>
+using SimulationComponents = Holder<Position, SpriteRenderer, AnimatedSprite, RectangleRenderer, RigidBody, Player, Carrot,
+    Plant, Temporary, Particle, Turnip, Enemy, DeadEnemy, Spawner, Foreground, Background, InView,
+    OffView<0>, OffView<1>, OffView<2>, OffView<3>>;
+static_assert(enemyLodInterval == 4, "Every off view slice has to be a simulation component");
+using SimulationWorld = SimulationComponents<WorldSnapshot>;
+using SimulationCensus = SimulationComponents<ComponentCensus>;
+using SimulationCounts = SimulationCensus::Counts;
+
+// Entity counts the pools the game owns are sized for at the start of a game, sessions measure their own
+// peaks through Game::Census and can hand them back with Game::SetCapacityHints
+SimulationCounts DefaultCapacityHints()
+{
+    SimulationCounts hints;
+    hints.Set<Position>(1024);
+    hints.Set<Player>(4);
+    hints.Set<Plant>(256);
+    hints.Set<RigidBody>(128);
+    hints.Set<Particle>(512);
+    hints.Set<Enemy>(64);
+    hints.Set<DeadEnemy>(64);
+    hints.Set<Turnip>(8);
+    hints.Set<Spawner>(16);
+    return hints;
+}
+
+// Everything Game::Step reads besides the level and the inputs
+struct SimulationState
+{
+    SimulationWorld world;
+    GameState gameState;
+    GameOverCause gameOverCause;
+    int score;
+    Random random;
+    float carrotX;
+    float stepInterval;
+    tako::U32 step;
+};
+
 class Game
 {
 public:
     void Setup(tako::PixelArtDrawer* drawer) {
         m_drawer = drawer;
-        srand(time(NULL));
-        drawer->SetTargetSize(240, 135);
+        m_resources.Setup(drawer);
+        drawer->SetTargetSize(viewWidth, viewHeight);
         drawer->AutoScale();
         m_cameraSize = drawer->GetCameraViewSize();
+        m_drawnViewSize.store(m_cameraSize, std::memory_order_relaxed);
+        // Hot reload edits the loose files, the archive would shadow them
+#if defined(LD46_ASSET_ARCHIVE) && !defined(LD46_HOT_RELOAD_DIR)
+        if (!m_archive.Open(LD46_ASSET_ARCHIVE))
+        {
+            LOG_ERR("Could not open asset archive {}, loading loose files", LD46_ASSET_ARCHIVE);
+        }
+#endif
         m_font = new tako::Font("/charmap-cellphone.png", 5, 7, 1, 1, 2, 2,
                                 " !\"#$%&'()*+,-./0123456789:;<=>?@ABCDEFGHIJKLMNOPQRSTUVWXYZ[\\]\a_`abcdefghijklmnopqrstuvwxyz{|}~");
         m_textPressAny = CreateText(drawer, m_font, "Press a button to start");
-        m_textTitle = CreateText(drawer, m_font, "Bunny Plague");
-        m_textControls = CreateText(drawer, m_font, "WASD - Move/Jump\n L/C - Pickup/Throw\n K/X - Pickup/Eat");
-        m_textCredits = CreateText(drawer, m_font, "Made in 48 hours by Malai\nLudum Dare 46 - Keep it alive");
+        m_hud.Setup(m_font, m_resources);
+        m_images =
+        {
+            {"/Plant.png", nullptr, {{&m_plantStates[0], 0, 0, 16, 16}, {&m_plantStates[1], 16, 0, 16, 16}, {&m_plantStates[2], 32, 0, 16, 16}}},
+            {"/TurnipUI.png", &m_turnipUI, {{&m_turnip, 0, 0, 8, 8}}},
+            {"/Hearth.png", &m_hearthUI, {}},
+            {"/RabbitUI.png", &m_rabbitUI, {}},
+            {"/Rabbit.png", nullptr, {}},
+            {"/Carrot.png", nullptr, {{&m_carrot, 0, 0, 16, 32}}},
+            {"/Player.png", nullptr, {}}
+        };
+        for (auto& image : m_images)
+        {
+            m_animations.ForEachSlot(image.file, [&](tako::Sprite** slot, float x, float y, float w, float h)
+            {
+                image.sprites.push_back({slot, x, y, w, h});
+            });
+            LoadImage(image);
+        }
+        m_clips =
+        {
+            {"/Step.wav", &m_clipStep, {0, 2, SoundPriority::Low}},
+            {"/Harvest.wav", &m_harvest, {0, 2, SoundPriority::Normal}},
+            {"/Eat.wav", &m_clipEat, {0, 1, SoundPriority::Normal}},
+            {"/Throw.wav", &m_clipThrow, {0, 2, SoundPriority::Normal}},
+            {"/Broke.wav", &m_clipBroke, {0, 3, SoundPriority::Low}},
+            {"/Kill.wav", &m_clipKill, {0, 3, SoundPriority::Normal}},
+            {"/Hurt.wav", &m_clipHurt, {0, 2, SoundPriority::High}},
+            {"/Death.wav", &m_clipDeath, {0, 2, SoundPriority::High}},
+            {"/Jump.wav", &m_clipJump, {0, 1, SoundPriority::Normal}}
+        };
+        // Voices are held for the playing time of the clip
+        for (auto& clip : m_clips)
+        {
+            clip.settings.length = WavLength(clip.file);
+            if (clip.settings.length == 0)
+            {
+                LOG_ERR("Could not read the length of {}", clip.file);
+            }
+            clip.loaded = m_resources.Clip(clip.file);
+            *clip.clip = clip.loaded.Get();
+            m_sound.Register(*clip.clip, clip.settings);
+        }
+        m_music = m_resources.Clip("/music.mp3");
+#ifdef LD46_HOT_RELOAD_DIR
+        m_assetWatcher.Watch(LD46_HOT_RELOAD_DIR);
+#endif
+#ifdef LD46_LATE_LATCH
+        m_lateLatch = true;
+#endif
+    }
+
+    void LoadImage(ImageAsset& image)
+    {
+        image.loaded = m_resources.Texture(image.file);
+        if (image.texture)
+        {
+            *image.texture = image.loaded.Get();
+        }
+        for (auto& frame : image.sprites)
+        {
+            image.frames.push_back(m_resources.Sprite(image.file, frame.x, frame.y, frame.w, frame.h));
+            *frame.sprite = image.frames.back().Get();
+        }
+    }
+
+    // The cache overwrites sprites in place, so every Sprite* handed out stays valid. Textures and clips are
+    // replaced and have to be picked up again
+    void ReloadAsset(std::string_view file)
+    {
+        if (!CopyWatchedAsset(file))
         {
-            auto bitmap = tako::Bitmap::FromFile("/Plant.png");
-            auto plantTex = drawer->CreateTexture(bitmap);
-            for (int i = 0; i < m_plantStates.size(); i++) {
-                m_plantStates[i] = drawer->CreateSprite(plantTex, i * 16, 0, 16, 16);
+            return;
+        }
+        for (auto& image : m_images)
+        {
+            if (file == image.file + 1)
+            {
+                m_resources.Reload(image.file);
+                if (image.texture)
+                {
+                    *image.texture = image.loaded.Get();
+                }
+                m_assetVersion++;
+                return;
             }
         }
+        for (auto& clip : m_clips)
         {
-            auto bitmap = tako::Bitmap::FromFile("/TurnipUI.png");
-            m_turnipUI = drawer->CreateTexture(bitmap);
-            m_turnip = drawer->CreateSprite(m_turnipUI, 0, 0, 8, 8);
+            if (file == clip.file + 1)
+            {
+                m_resources.Reload(clip.file);
+                m_sound.Replace(*clip.clip, clip.loaded.Get(), WavLength(clip.file));
+                *clip.clip = clip.loaded.Get();
+                return;
+            }
         }
+        if (file == "Tileset.png")
         {
-            auto bitmap = tako::Bitmap::FromFile("/Hearth.png");
-            m_hearthUI = drawer->CreateTexture(bitmap);
+            m_resources.Reload("/Tileset.png");
+            return;
         }
+        if (file == "Level.txt" && m_level)
         {
-            auto bitmap = tako::Bitmap::FromFile("/RabbitUI.png");
-            m_rabbitUI = drawer->CreateTexture(bitmap);
+            ReloadLevelTiles();
         }
+    }
+
+    // Tako loads assets from its copy next to the executable, so an edited file is copied over it first and
+    // every reload reads the same bytes
+    bool CopyWatchedAsset(std::string_view file)
+    {
+#ifdef LD46_HOT_RELOAD_DIR
+        std::string name(file);
+        std::ifstream source(std::string(LD46_HOT_RELOAD_DIR) + "/" + name, std::ios::binary);
+        std::ofstream copy(std::string(LD46_HOT_RELOAD_COPY_DIR) + "/" + name, std::ios::binary | std::ios::trunc);
+        if (!source || !copy || !(copy << source.rdbuf()))
         {
-            auto bitmap = tako::Bitmap::FromFile("/Rabbit.png");
-            auto tex = drawer->CreateTexture(bitmap);
-            m_rabbit = drawer->CreateSprite(tex, 0, 0, 12, 12);
-            m_rabbitJump = drawer->CreateSprite(tex, 12, 0, 12, 12);
-            m_rabbitDead = drawer->CreateSprite(tex, 24, 0, 12, 12);
-            //Hack of the year
-            m_rabbitR = drawer->CreateSprite(tex, 12, 0, -12, 12);
-            m_rabbitJumpR = drawer->CreateSprite(tex, 24, 0, -12, 12);
-            m_rabbitDeadR = drawer->CreateSprite(tex, 36, 0, -12, 12);
+            LOG_ERR("Could not copy {} to the loaded assets", name);
+            return false;
         }
+#endif
+        return true;
+    }
+
+    // Only tiles are diffed, entity markers (p, P, S, C) need a restart to take effect
+    void ReloadLevelTiles()
+    {
+#ifdef LD46_HOT_RELOAD_DIR
+        std::ifstream file(std::string(LD46_HOT_RELOAD_COPY_DIR) + "/Level.txt", std::ios::binary);
+        std::stringstream content;
+        content << file.rdbuf();
+        LevelCallbacks noCallbacks;
+        Level edited(content.str(), noCallbacks);
+        if (edited.Width() != m_level->Width() || edited.Height() != m_level->Height())
         {
-            auto bitmap = tako::Bitmap::FromFile("/Carrot.png");
-            auto carTex = drawer->CreateTexture(bitmap);
-            m_carrot = drawer->CreateSprite(carTex, 0, 0, 16, 32);
+            LOG_ERR("Level size changed, restart to apply");
+            return;
         }
+        int changed = 0;
+        for (int y = 0; y <= m_level->Height(); y++)
         {
-            auto bitmap = tako::Bitmap::FromFile("/Player.png");
-            auto playerTex = drawer->CreateTexture(bitmap);
-            m_playerJump = drawer->CreateSprite(playerTex, 36, 0, 12, 12);
-            m_player = drawer->CreateSprite(playerTex, 0, 0, 12, 12);
-            m_playerWalk1 = drawer->CreateSprite(playerTex, 12, 0, 12, 12);
-            m_playerWalk2 = drawer->CreateSprite(playerTex, 24, 0, 12, 12);
-            m_playerR = drawer->CreateSprite(playerTex, 12, 0, -12, 12);
-            m_playerWalk1R = drawer->CreateSprite(playerTex, 24, 0, -12, 12);
-            m_playerWalk2R = drawer->CreateSprite(playerTex, 36, 0, -12, 12);
+            for (int x = 0; x < m_level->Width(); x++)
+            {
+                int tile = edited.GetTile(x, y);
+                if (tile != m_level->GetTile(x, y))
+                {
+                    m_level->SetTile(x, y, tile);
+                    m_navigation.TileChanged(x, y);
+                    changed++;
+                }
+            }
         }
-        m_clipStep = new tako::AudioClip("/Step.wav");
-        m_harvest = new tako::AudioClip("/Harvest.wav");
-        m_clipEat = new tako::AudioClip("/Eat.wav");
-        m_clipThrow = new tako::AudioClip("/Throw.wav");
-        m_clipBroke = new tako::AudioClip("/Broke.wav");
-        m_clipMusic = new tako::AudioClip("/music.mp3");
-        m_clipKill = new tako::AudioClip("/Kill.wav");
-        m_clipHurt = new tako::AudioClip("/Hurt.wav");
-        m_clipDeath = new tako::AudioClip("/Death.wav");
-        m_clipJump = new tako::AudioClip("/Jump.wav");
+        if (changed > 0)
+        {
+            m_navigation.Refresh();
+        }
+#endif
     }
 
-    void StartGame()
+    // Without a level string the level is loaded from the assets, lockstep sessions turn streaming off
+    // so that all peers simulate every entity of the level
+    void StartGame(tako::U32 seed, std::string_view levelStr = {}, bool streaming = true)
     {
-        std::map<char, std::function<void(int,int)>> levelCallbacks
-        {{
+        m_random.Seed(seed);
+        m_streaming = streaming;
+        m_step = 0;
+        m_plantTimers.Clear(m_step);
+        int carrotTileX = 0;
+        int carrotTileY = 0;
+        std::vector<ChunkRecord> records;
+        LevelCallbacks levelCallbacks
+        ({
             { 'p', [&](int x, int y)
             {
-                auto plant = m_world.Create<Position, SpriteRenderer, Plant, Foreground>();
-                Position& pos = m_world.GetComponent<Position>(plant);
-                pos.x = x * 16 + 8;
-                pos.y = y * 16 + 8;
-                SpriteRenderer& renderer = m_world.GetComponent<SpriteRenderer>(plant);
-                renderer.size = { 16, 16};
-                Plant& pl = m_world.GetComponent<Plant>(plant);
-                pl.Reset();
-                pl.growth = 0;
+                Plant pl;
+                pl.Reset(m_random, m_step);
+                records.push_back({ChunkRecordType::Plant, {x * 16 + 8.0f, y * 16 + 8.0f}, {0, 0}, 0, pl.growthRate});
             }},
             { 'P', [&](int x, int y)
             {
-                auto player = m_world.Create<Position, SpriteRenderer, RigidBody, Player, Foreground>();
-                Position& pos = m_world.GetComponent<Position>(player);
-                pos.x = x * 16 + 8;
-                pos.y = y * 16 + 8;
-                SpriteRenderer& renderer = m_world.GetComponent<SpriteRenderer>(player);
-                renderer.size = { 12, 12};
-                renderer.sprite = m_player;
-                RigidBody& rigid = m_world.GetComponent<RigidBody>(player);
-                rigid.size = { 12, 12 };
-                rigid.entity = player;
-                Player& pl = m_world.GetComponent<Player>(player);
-                pl.hunger = 100;
-                pl.displayedHunger = 0;
-                pl.turnip = std::nullopt;
-                pl.lookDirection = 1;
-                pl.airTime = 0.0f;
-                pl.speed = {0, 0};
+                CreatePlayer({x * 16 + 8.0f, y * 16 + 8.0f});
             }},
             { 'S', [&](int x, int y)
             {
-                auto spawn = m_world.Create<Spawner>();
-                auto& sp = m_world.GetComponent<Spawner>(spawn);
-                sp.x = x;
-                sp.y = y;
-                sp.duration = 0;
+                records.push_back({ChunkRecordType::Spawner, {x * 16 + 8.0f, y * 16 + 8.0f}, {0, 0}, 0, 0, m_step});
             }},
             { 'C', [&](int x, int y)
             {
-                auto carrot = m_world.Create<Position, SpriteRenderer, Background, Carrot, RigidBody>();
-                Position& pos = m_world.GetComponent<Position>(carrot);
-                pos.x = x * 16 + 8;
-                pos.y = y * 16 + 16;
-                SpriteRenderer& renderer = m_world.GetComponent<SpriteRenderer>(carrot);
-                renderer.size = { 16, 32};
-                renderer.sprite = m_carrot;
-                auto& rigid = m_world.GetComponent<RigidBody>(carrot);
-                rigid.entity = carrot;
-                rigid.size = { 16, 32 };
-                auto& c = m_world.GetComponent<Carrot>(carrot);
-                c.health = 100;
-                c.displayHealth = 0;
+                CreateCarrot({x * 16 + 8.0f, y * 16 + 16.0f});
+                carrotTileX = x;
+                carrotTileY = y;
             }}
-        }};
-        m_level = new Level("/Level.txt", m_drawer, levelCallbacks);
+        }, &m_frameArena);
+        delete m_level;
+        m_level = levelStr.empty() ? new Level("/Level.txt", m_resources, levelCallbacks) : new Level(levelStr, levelCallbacks);
+        m_navigation.Build(m_level, carrotTileX, carrotTileY);
+        PlaceRecords(records);
         m_gameState = GameState::Starting;
+        m_census.Reset();
+        ReservePools();
+        SaveState(m_startState);
+        m_startRecords = m_streaming ? std::move(records) : std::vector<ChunkRecord>();
+    }
+
+    // Puts the simulation back to where StartGame left it, the level and its navigation are reused
+    void Restart()
+    {
+        LoadState(m_startState);
+        m_spawned = true;
+        if (m_streaming)
+        {
+            m_streamer.Setup(m_level, 1, m_startRecords);
+        }
+        m_census.Reset();
+        m_gameOverTime = 0;
+    }
+
+    void SetCapacityHints(const SimulationCounts& hints)
+    {
+        m_capacityHints = hints;
+    }
+
+    bool IsStreamedIn(tako::Vector2 position)
+    {
+        return !m_streaming || m_streamer.IsActive(position);
+    }
+
+    size_t TileMemory()
+    {
+        return m_level ? m_level->TileMemory() : 0;
+    }
+
+    // Live entity counts after the last step that created any, and the peaks since the game started
+    const SimulationCensus& Census()
+    {
+        return m_census;
+    }
+
+    // Sizes the scratch pools of the simulation for the hinted counts, tako::World manages its own storage
+    void ReservePools()
+    {
+        m_moveBatch.Reserve(m_capacityHints.Get<RigidBody>());
+        m_particleBatch.Reserve(m_capacityHints.Get<Particle>());
+        m_corpseBatch.Reserve(m_capacityHints.Get<DeadEnemy>());
+        auto enemies = m_capacityHints.Get<Enemy>();
+        m_events.Reserve<Landed>(enemies);
+        m_events.Reserve<Hopped>(enemies);
+        m_events.Reserve<Killed>(enemies);
+        m_events.Reserve<CarrotHurt>(enemies);
+        m_events.Reserve<TurnipBroke>(m_capacityHints.Get<Turnip>());
+        m_plantTimers.Reserve(m_capacityHints.Get<Plant>());
+        m_simulationViews.reserve(m_capacityHints.Get<Player>());
+        m_lodMoves.reserve(enemies);
+        m_streamCenters.reserve(m_capacityHints.Get<Player>());
+    }
+
+    tako::Entity CreatePlayer(Position position)
+    {
+        m_spawned = true;
+        return m_playerPrefab.Instantiate(m_world, [&](tako::Entity player, Position& pos, AnimatedSprite& animation, RigidBody& rigid, Player& pl, Foreground& f)
+        {
+            pos = position;
+            rigid.entity = player;
+            m_world.IterateComps<Player>([&](Player& other)
+            {
+                if (&other != &pl)
+                {
+                    pl.slot++;
+                }
+            });
+        });
+    }
+
+    tako::Entity CreateCarrot(Position position)
+    {
+        m_spawned = true;
+        return m_carrotPrefab.Instantiate(m_world, [&](tako::Entity carrot, Position& pos, SpriteRenderer& renderer, Background& b, Carrot& c, RigidBody& rigid)
+        {
+            pos = position;
+            renderer.sprite = m_carrot;
+            rigid.entity = carrot;
+        });
+    }
+
+    void PlaceRecords(std::vector<ChunkRecord>& records)
+    {
+        if (m_streaming)
+        {
+            m_streamer.Setup(m_level, 1, records);
+            return;
+        }
+        for (auto& record : records)
+        {
+            ReviveRecord(record);
+        }
     }
 
     void SpawnParticles(tako::Vector2 origin, int amount, float minX, float maxX, float minY, float maxY)
     {
-        for (int i = 0; i < amount; i++)
+        m_spawned = true;
+        m_particlePrefab.CreateMany(m_world, amount, [&](int i, tako::Entity particle, Position& pPos, RectangleRenderer& pRen, Temporary& pTmp, Particle& pPar)
         {
-            auto particle = m_world.Create<Position, RectangleRenderer, Temporary, Particle>();
-            auto& pPos = m_world.GetComponent<Position>(particle);
             pPos.x = origin.x;
             pPos.y = origin.y;
-            auto& pRen = m_world.GetComponent<RectangleRenderer>(particle);
-            pRen.size = { 1, 1 };
-            pRen.color = { 255, 255, 255, 255};
-            auto& pTmp = m_world.GetComponent<Temporary>(particle);
-            pTmp.left = 30 + rand() % 100 / 10.0f;
-            auto& pPar = m_world.GetComponent<Particle>(particle);
-            pPar.speed = tako::Vector2(((float)rand()) / RAND_MAX * (maxX - minX) + minX, ((float)rand()) / RAND_MAX * (maxY - minY) + minY);
+            pTmp.left = 30 + m_random.Int(100) / 10.0f;
+            pTmp.entity = particle;
+            pPar.speed = tako::Vector2(m_random.Value() * (maxX - minX) + minX, m_random.Value() * (maxY - minY) + minY);
+        });
+    }
+
+    void ReviveRecord(const ChunkRecord& record)
+    {
+        m_spawned = true;
+        switch (record.type)
+        {
+            case ChunkRecordType::Plant:
+            {
+                auto plant = m_plantPrefab.Instantiate(m_world, [&](tako::Entity plant, Position& pos, SpriteRenderer& renderer, Plant& pl, Foreground& f)
+                {
+                    pos = {record.position.x, record.position.y};
+                    pl.growthRate = record.value;
+                    pl.SetGrowth(record.timer, m_step);
+                });
+                UpdatePlantStage(plant);
+                break;
+            }
+            case ChunkRecordType::Enemy:
+            {
+                m_rabbitPrefab.Instantiate(m_world, [&](tako::Entity enemy, Position& pos, AnimatedSprite& animation, RigidBody& rigid, Enemy& en, Foreground& f, InView& v)
+                {
+                    pos = {record.position.x, record.position.y};
+                    animation.flip = record.value < 0;
+                    rigid.entity = enemy;
+                    en = {record.speed, record.timer, record.value, m_step, -1};
+                });
+                break;
+            }
+            case ChunkRecordType::DeadEnemy:
+            {
+                m_deadRabbitPrefab.Instantiate(m_world, [&](tako::Entity dead, Position& pos, AnimatedSprite& animation, DeadEnemy& enm, Background& b)
+                {
+                    pos = {record.position.x, record.position.y};
+                    animation.flip = record.value < 0;
+                    enm = {record.speed, record.timer};
+                });
+                break;
+            }
+            case ChunkRecordType::Spawner:
+            {
+                // The timer kept running while paged out, but at most one missed rabbit waits on the spawner
+                int x = (int) record.position.x / 16;
+                int y = (int) record.position.y / 16;
+                float duration = record.timer - (m_step - record.step) * simulationStep;
+                if (duration <= 0)
+                {
+                    SpawnRabbit(x, y);
+                    duration = SpawnInterval();
+                }
+                m_spawnerPrefab.Instantiate(m_world, [&](tako::Entity spawn, Spawner& sp)
+                {
+                    sp = {x, y, duration};
+                });
+                break;
+            }
         }
     }
 
+    void StreamChunks(std::pmr::vector<tako::Entity>& toRemove)
+    {
+        m_streamCenters.clear();
+        m_world.IterateComps<Position, Player>([&](Position& pos, Player& player)
+        {
+            m_streamCenters.push_back(pos.AsVec());
+        });
+        m_streamer.Update(m_streamCenters, [&](const ChunkRecord& record)
+        {
+            ReviveRecord(record);
+        });
+        SerializeEntities([&](tako::Vector2 pos) { return !m_streamer.IsActive(pos); }, [&](const ChunkRecord& record, tako::Entity entity)
+        {
+            if (record.type == ChunkRecordType::Plant)
+            {
+                m_plantTimers.Cancel(m_world.GetComponent<Plant>(entity).stageTimer);
+            }
+            m_streamer.Store(record);
+            toRemove.push_back(entity);
+        });
+    }
+
+    template<typename Filter, typename Store>
+    void SerializeEntities(Filter&& filter, Store&& store)
+    {
+        m_world.IterateHandle<Position, Plant>([&](tako::EntityHandle handle)
+        {
+            auto& pos = m_world.GetComponent<Position>(handle.id);
+            if (filter(pos.AsVec()))
+            {
+                auto& plant = m_world.GetComponent<Plant>(handle.id);
+                store({ChunkRecordType::Plant, pos.AsVec(), {0, 0}, plant.Growth(m_step), plant.growthRate}, handle.id);
+            }
+        });
+        m_world.IterateHandle<Position, Enemy>([&](tako::EntityHandle handle)
+        {
+            auto& pos = m_world.GetComponent<Position>(handle.id);
+            if (filter(pos.AsVec()))
+            {
+                auto& enemy = m_world.GetComponent<Enemy>(handle.id);
+                store({ChunkRecordType::Enemy, pos.AsVec(), enemy.speed, enemy.groundTime, enemy.direction}, handle.id);
+            }
+        });
+        m_world.IterateHandle<Position, DeadEnemy, AnimatedSprite>([&](tako::EntityHandle handle)
+        {
+            auto& pos = m_world.GetComponent<Position>(handle.id);
+            if (filter(pos.AsVec()))
+            {
+                auto& dead = m_world.GetComponent<DeadEnemy>(handle.id);
+                auto& animation = m_world.GetComponent<AnimatedSprite>(handle.id);
+                store({ChunkRecordType::DeadEnemy, pos.AsVec(), dead.speed, dead.groundTime, animation.flip ? -1.0f : 1.0f}, handle.id);
+            }
+        });
+        m_world.IterateHandle<Spawner>([&](tako::EntityHandle handle)
+        {
+            auto& spawn = m_world.GetComponent<Spawner>(handle.id);
+            tako::Vector2 pos(spawn.x * 16 + 8, spawn.y * 16 + 8);
+            if (filter(pos))
+            {
+                store({ChunkRecordType::Spawner, pos, {0, 0}, spawn.duration, 0, m_step}, handle.id);
+            }
+        });
+    }
+
     void Update(tako::Input* input, float dt)
     {
+        UpdateState(input, dt);
+        PublishRenderFrame();
+    }
+
+    // Draws move the local player and camera with the buttons sampled right before them, the simulation only sees
+    // the input sampled by Update
+    void SetLateLatch(bool enabled)
+    {
+        m_lateLatch = enabled;
+    }
+
+    InputLatencyStats LatencyStats() const
+    {
+        return m_latency.Stats();
+    }
+
+    // Captures what is visible now into the back render frame and hands it to Draw
+    void PublishRenderFrame()
+    {
+        auto& frame = m_renderFrames.Back();
+        frame.state = m_gameState;
+        frame.gameOverCause = m_gameOverCause;
+        frame.camera = m_cameraPos;
+        frame.viewSize = m_cameraSize;
+        frame.score = m_score;
+        frame.assetVersion = m_assetVersion;
+        frame.tiles.clear();
+        frame.items.clear();
+        // Sized for the most entities seen so far, so the list only grows when the world reaches a new peak
+        frame.items.reserve(std::max(m_capacityHints.Get<Position>(), m_census.HighWater().Get<Position>()));
+        frame.inputSerial = m_latency.SteppedSerial();
+        frame.playerItem = -1;
+        frame.sinceStep = m_stepTime;
+        frame.cameraFrom = m_cameraFrom;
+        frame.cameraBlend = m_cameraBlend;
+        if (m_gameState == GameState::InGame || m_gameState == GameState::GameOver)
+        {
+            frame.mapBounds = m_level->MapBounds();
+            auto tileView = m_cameraSize + tako::Vector2(publishedTileMargin * 2, publishedTileMargin * 2);
+            frame.tiles.reserve(size_t((tileView.x / 16 + 2) * (tileView.y / 16 + 3)));
+            RenderListWriter tiles(frame.tiles, RenderLayer::Tiles);
+            m_level->Draw(&tiles, {m_cameraPos, tileView});
+            const Position* localPlayer = nullptr;
+            m_world.IterateComps<Position, Player>([&](Position& pos, Player& player)
+            {
+                if (player.slot == m_localSlot)
+                {
+                    localPlayer = &pos;
+                    frame.playerSpeed = player.speed.x;
+                }
+            });
+            m_world.IterateComps<Position, RectangleRenderer>([&](Position& pos, RectangleRenderer& rect)
+            {
+                frame.items.push_back({pos.AsVec(), rect.size, nullptr, rect.color, RenderLayer::Rectangles});
+            });
+            m_world.IterateComps<Position, SpriteRenderer, Background>([&](Position& pos, SpriteRenderer& sprite, Background& b)
+            {
+                frame.items.push_back({pos.AsVec(), sprite.size, sprite.sprite, {}, RenderLayer::Background});
+            });
+            m_world.IterateComps<Position, AnimatedSprite, Background>([&](Position& pos, AnimatedSprite& animation, Background& b)
+            {
+                frame.items.push_back({pos.AsVec(), animation.size, m_animations.Sprite(animation), {}, RenderLayer::Background});
+            });
+            m_world.IterateComps<Position, SpriteRenderer, Foreground>([&](Position& pos, SpriteRenderer& sprite, Foreground& f)
+            {
+                frame.items.push_back({pos.AsVec(), sprite.size, sprite.sprite, {}, RenderLayer::Foreground});
+            });
+            m_world.IterateComps<Position, AnimatedSprite, Foreground>([&](Position& pos, AnimatedSprite& animation, Foreground& f)
+            {
+                if (&pos == localPlayer)
+                {
+                    frame.playerItem = frame.items.size();
+                    frame.playerFlip = animation.flip;
+                    auto facing = animation;
+                    for (bool flip : {false, true})
+                    {
+                        facing.flip = flip;
+                        frame.playerSprites[flip] = m_animations.Sprite(facing);
+                    }
+                }
+                frame.items.push_back({pos.AsVec(), animation.size, m_animations.Sprite(animation), {}, RenderLayer::Foreground});
+            });
+            frame.carrotHealth = 0;
+            for (auto[carrot] : m_world.Iter<Carrot>()) {
+                frame.carrotHealth = carrot.displayHealth;
+                break;
+            }
+            frame.playerHunger = 0;
+            m_world.IterateComps<Player>([&](Player& player)
+            {
+                if (player.slot == m_localSlot)
+                {
+                    frame.playerHunger = player.displayedHunger;
+                }
+            });
+        }
+        m_renderFrames.Publish();
+    }
+
+    template<typename Reader>
+    void ReadRenderFrame(Reader reader)
+    {
+        m_renderFrames.Read(reader);
+    }
+
+    void UpdateState(tako::Input* input, float dt)
+    {
+        m_cameraSize = m_drawnViewSize.load(std::memory_order_relaxed);
+        m_toRemove = std::pmr::vector<tako::Entity>(&m_frameArena);
+        m_frameArena.Reset();
+        for (auto& file : m_assetWatcher.Poll())
+        {
+            ReloadAsset(file);
+        }
         if (m_gameState == GameState::PressAny)
         {
             for (int i = 0; i < (int) tako::Key::Unknown; i++)
@@ -269,124 +963,169 @@ public:
                 if (input->GetKeyDown((tako::Key) i))
                 {
                     m_gameState = GameState::StartMenu;
-                    tako::Audio::Play(*m_clipMusic, true);
+                    tako::Audio::Play(*m_music, true);
                     break;
                 }
             }
             return;
         }
-        if (m_gameState == GameState::StartMenu)
+        if (m_gameState == GameState::StartMenu)
+        {
+            for (int i = 0; i < (int) tako::Key::Unknown; i++)
+            {
+                if (input->GetKeyDown((tako::Key) i))
+                {
+                    StartGame(time(NULL));
+                    break;
+                }
+            }
+            return;
+        }
+        if (m_gameState == GameState::GameOver)
+        {
+            m_gameOverTime += dt;
+            for (int i = 0; i < (int) tako::Key::Unknown && m_gameOverTime > 1; i++)
+            {
+                if (input->GetKeyDown((tako::Key) i))
+                {
+                    Restart();
+                    return;
+                }
+            }
+        }
+
+        Simulate(ReadInput(input), dt, InputLatency::Clock::now());
+    }
+
+    // The in game part of Update with the input already sampled, so it can be scripted without a window
+    void Simulate(PlayerInput sampled, float dt, InputLatency::Clock::time_point now)
+    {
+        m_latency.Sample(sampled, now);
+        m_localInput = sampled | (m_localInput & InputButton::OneShot);
+        m_stepTime += dt;
+        int steps = 0;
+        while (m_stepTime >= simulationStep && steps < maxStepsPerFrame)
+        {
+            Step(&m_localInput, 1);
+            m_latency.Stepped();
+            m_localInput &= ~InputButton::OneShot;
+            m_stepTime -= simulationStep;
+            steps++;
+        }
+        if (steps == maxStepsPerFrame)
+        {
+            m_stepTime = 0;
+        }
+
+        m_world.IterateComps<Position, Player>([&](Position& pos, Player& player)
         {
-            for (int i = 0; i < (int) tako::Key::Unknown; i++)
+            if (player.slot == m_localSlot)
             {
-                if (input->GetKeyDown((tako::Key) i))
-                {
-                    StartGame();
-                    break;
-                }
+                m_cameraTarget = FitMapBound(m_level->MapBounds(), pos.AsVec(), m_cameraSize);
             }
-            return;
+        });
+        m_cameraFrom = m_cameraPos;
+        m_cameraBlend = dt * 2;
+        m_cameraPos += (m_cameraTarget - m_cameraPos) * m_cameraBlend;
+        m_cameraPos = FitMapBound(m_level->MapBounds(), m_cameraPos, m_cameraSize);
+        m_sound.Flush(dt);
+    }
+
+    static PlayerInput ReadInput(tako::Input* input)
+    {
+        PlayerInput buttons = 0;
+        if (input->GetKey(tako::Key::Left) || input->GetKey(tako::Key::A) || input->GetKey(tako::Key::Gamepad_Dpad_Left))
+        {
+            buttons |= InputButton::Left;
+        }
+        if (input->GetKey(tako::Key::Right) || input->GetKey(tako::Key::D) || input->GetKey(tako::Key::Gamepad_Dpad_Right))
+        {
+            buttons |= InputButton::Right;
+        }
+        if (input->GetKey(tako::Key::Up) || input->GetKey(tako::Key::W) || input->GetKey(tako::Key::Space) || input->GetKey(tako::Key::Gamepad_A))
+        {
+            buttons |= InputButton::Jump;
+        }
+        if (input->GetKeyDown(tako::Key::L) || input->GetKeyDown(tako::Key::C) || input->GetKeyDown(tako::Key::Gamepad_B))
+        {
+            buttons |= InputButton::Throw;
+        }
+        if (input->GetKeyDown(tako::Key::K) || input->GetKeyDown(tako::Key::X) || input->GetKeyDown(tako::Key::Gamepad_X))
+        {
+            buttons |= InputButton::Eat;
         }
+        return buttons;
+    }
+
+    // Advances the game by one fixed step. Everything it reads comes from the world, the simulation members and inputs,
+    // indexed by player slot, so the same state and inputs always produce the same result
+    void Step(const PlayerInput* inputs, int count)
+    {
+        constexpr auto dt = simulationStep;
+        auto& events = m_events.Writer();
+        m_step++;
         if (m_gameState == GameState::Starting)
         {
             m_gameState = GameState::InGame;
         }
-        static std::vector<tako::Entity> toRemove;
-        for (auto ent : toRemove)
+        if (m_streaming)
         {
-            m_world.Delete(ent);
+            StreamChunks(m_toRemove);
         }
-        toRemove.clear();
-        m_world.IterateHandle<Temporary>([&](tako::EntityHandle& handle)
+        m_world.IterateComps<Temporary>([&](Temporary& tmp)
         {
-            Temporary& tmp = m_world.GetComponent<Temporary>(handle.id);
             tmp.left -= dt;
             if (tmp.left < 0)
             {
-                toRemove.push_back(handle.id);
+                m_toRemove.push_back(tmp.entity);
             }
         });
-        for (auto ent : toRemove)
+        for (auto ent : m_toRemove)
         {
             m_world.Delete(ent);
         }
-        toRemove.clear();
-        m_world.IterateHandle<Position, Player, RigidBody, SpriteRenderer>([&](tako::EntityHandle handle)
+        m_toRemove.clear();
+        m_world.IterateComps<Position, Player, RigidBody, AnimatedSprite>([&](Position& pos, Player& player, RigidBody& rigid, AnimatedSprite& animation)
         {
-            Position& pos = m_world.GetComponent<Position>(handle.id);
-            Player& player = m_world.GetComponent<Player>(handle.id);
-            RigidBody& rigid = m_world.GetComponent<RigidBody>(handle.id);
-            SpriteRenderer& renderer = m_world.GetComponent<SpriteRenderer>(handle.id);
-            constexpr auto speed = 64;
+            PlayerInput buttons = player.slot < count ? inputs[player.slot] : 0;
             player.hunger = std::max(0.0f, player.hunger - dt * 2);
             player.displayedHunger = std::max(0.0f, player.displayedHunger - dt * 2);
             player.displayedHunger += (player.hunger - player.displayedHunger) * dt * 3;
             if (player.hunger <= 0 && player.displayedHunger < 3)
             {
                 player.displayedHunger = 0;
-                toRemove.push_back(handle.id);
-                SpawnParticles(pos.AsVec(), 64, -20, 20, -10, 50);
-                tako::Audio::Play(*m_clipDeath);
-                if (m_gameState != GameState::GameOver)
-                {
-                    m_gameState = GameState::GameOver;
-                    std::stringstream str;
-                    if (m_score < 25)
-                    {
-                        str << "You weren't able to keep yourself alive!\n"
-                            << "Eat turnips to satisfy your hunger!\n";
-                    }
-                    else
-                    {
-                        str << "You killed many hungry rabbits,\n"
-                            << "but you exhausted out of hunger!\n";
-                    }
-                    str << "Score: " << m_score << "\n"
-                        << "Thanks for playing!\n"
-                        << "Refresh for restart";
-
-                    m_textGameOver = CreateText(m_drawer, m_font, str.str());
-                }
+                m_toRemove.push_back(rigid.entity);
+                events.Emit(Died{pos.AsVec(), GameOverCause::Hunger});
             }
             bool grounded = Physics::IsGrounded(m_level, pos, rigid);
             player.speed.y = std::max(grounded ? 0 : -160.0f, player.speed.y - dt * 200);
             player.airTime = grounded ? 0 : player.airTime + dt;
             float moveX = 0;
-            if (input->GetKey(tako::Key::Left) || input->GetKey(tako::Key::A) || input->GetKey(tako::Key::Gamepad_Dpad_Left))
+            if (buttons & InputButton::Left)
             {
-                moveX -= speed;
+                moveX -= playerWalkSpeed;
             }
-            if (input->GetKey(tako::Key::Right) || input->GetKey(tako::Key::D) || input->GetKey(tako::Key::Gamepad_Dpad_Right))
+            if (buttons & InputButton::Right)
             {
-                moveX += speed;
+                moveX += playerWalkSpeed;
             }
-            constexpr auto acceleration = 0.2f;
             if (moveX != 0)
             {
                 player.lookDirection = tako::mathf::sign(moveX);
             }
-            player.speed.x = moveX = acceleration * moveX + (1 - acceleration) * player.speed.x;
+            player.speed.x = moveX = playerAcceleration * moveX + (1 - playerAcceleration) * player.speed.x;
             if (tako::mathf::abs(moveX) > 3)
             {
                 if (grounded)
                 {
-                    static float spawnInterval = 0.6f;
                     player.walkingPart += dt;
-                    player.stepPart += dt;
-                    if (tako::mathf::abs(player.walkingPart) > spawnInterval)
+                    if (tako::mathf::abs(player.walkingPart) > m_stepInterval)
                     {
-                        tako::Audio::Play(*m_clipStep);
-                        auto sign = tako::mathf::sign(moveX);
-                        SpawnParticles(pos.AsVec() - tako::Vector2(0, 5), 1, -5 * sign, -10 * sign, 10, 20);
+                        events.Emit(Stepped{pos.AsVec(), tako::mathf::sign(moveX)});
                         player.walkingPart = 0;
-                        spawnInterval = rand() * 1.0f / RAND_MAX * 0.4f + 0.4f;
-                    }
-                    if (player.stepPart > 0.1f)
-                    {
-                        player.stepPart -= 0.1f;
-                        player.stepIndex = !player.stepIndex;
+                        m_stepInterval = m_random.Value() * 0.4f + 0.4f;
                     }
-                    renderer.sprite = player.lookDirection > 0 ? (player.stepIndex ? m_playerWalk2R : m_playerWalk1R) : (player.stepIndex ? m_playerWalk2 : m_playerWalk1);
+                    m_animations.Play(animation, AnimationClip::PlayerWalk);
                 }
                 else if (player.walkingPart < 0)
                 {
@@ -396,27 +1135,28 @@ public:
             else
             {
                 player.walkingPart = std::min(0.0f, player.walkingPart - dt / 2);
-                renderer.sprite = player.lookDirection > 0 ? m_playerR : m_player;
+                m_animations.Play(animation, AnimationClip::PlayerIdle);
             }
             if (!grounded)
             {
-                renderer.sprite = m_playerJump;
+                m_animations.Play(animation, AnimationClip::PlayerJump);
             }
-            if (player.airTime < 0.3f && (input->GetKey(tako::Key::Up) || input->GetKey(tako::Key::W) || input->GetKey(tako::Key::Space) || input->GetKey(tako::Key::Gamepad_A)))
+            animation.flip = player.lookDirection > 0;
+            if (player.airTime < 0.3f && (buttons & InputButton::Jump))
             {
                 if (player.airTime == 0)
                 {
-                    tako::Audio::Play(*m_clipJump);
+                    events.Emit(Jumped{});
                 }
                 player.speed.y = 80;
             }
             float moveY = grounded ? std::max(0.0f, player.speed.y) : player.speed.y;
             bool hadTurnip = player.turnip.has_value();
-            bool throwPressed = input->GetKeyDown(tako::Key::L) || input->GetKeyDown(tako::Key::C) || input->GetKeyDown(tako::Key::Gamepad_B);
-            bool eatPressed = input->GetKeyDown(tako::Key::K) || input->GetKeyDown(tako::Key::X) || input->GetKeyDown(tako::Key::Gamepad_X);
+            bool throwPressed = buttons & InputButton::Throw;
+            bool eatPressed = buttons & InputButton::Eat;
             if (!hadTurnip && (throwPressed || eatPressed))
             {
-                Plant* pickup = nullptr;
+                std::optional<tako::Entity> pickup;
                 float minDistance = 999999999;
                 tako::Vector2 pickupPos;
                 Rect p(pos.AsVec(), rigid.size);
@@ -424,7 +1164,7 @@ public:
                 {
                     auto& pos = m_world.GetComponent<Position>(handle.id);
                     auto& plant = m_world.GetComponent<Plant>(handle.id);
-                    if (plant.growth < 10)
+                    if (plant.Stage(m_step) < 2)
                     {
                         return;
                     }
@@ -434,7 +1174,7 @@ public:
                         float distance = tako::mathf::abs((p.Position()-pl.Position()).magnitude());
                         if (distance < minDistance)
                         {
-                            pickup = &plant;
+                            pickup = handle.id;
                             minDistance = distance;
                             pickupPos = pl.Position();
                         }
@@ -442,17 +1182,11 @@ public:
                 });
                 if (pickup)
                 {
-                    pickup->Reset();
-                    tako::Audio::Play(*m_harvest);
-                    SpawnParticles({pickupPos.x, pickupPos.y - 3}, 5, -15, 15, 5, 40);
-                    auto turnip = m_world.Create<Position, SpriteRenderer, Foreground>();
-                    auto& tPos = m_world.GetComponent<Position>(turnip);
-                    tPos.x = pickupPos.x;
-                    tPos.y = pickupPos.y;
-                    auto& tRen = m_world.GetComponent<SpriteRenderer>(turnip);
-                    tRen.size = {8, 8};
-                    tRen.sprite = m_turnip;
-                    player.turnip = turnip;
+                    auto& plant = m_world.GetComponent<Plant>(pickup.value());
+                    m_plantTimers.Cancel(plant.stageTimer);
+                    plant.Reset(m_random, m_step);
+                    UpdatePlantStage(pickup.value());
+                    events.Emit(Harvested{rigid.entity, pickupPos});
                 }
             }
             if (hadTurnip && throwPressed)
@@ -462,23 +1196,24 @@ public:
                 auto& tBody = m_world.GetComponent<RigidBody>(turnip);
                 tBody.size = { 8, 8 };
                 tBody.entity = turnip;
+                tBody.tags = BodyTag::Turnip;
+                tBody.collidesWith = BodyTag::Enemy;
                 m_world.AddComponent<Turnip>(turnip);
                 auto& tTur = m_world.GetComponent<Turnip>(turnip);
                 tTur.speed = { 130 * player.lookDirection, 10 };
-                tako::Audio::Play(*m_clipThrow);
+                events.Emit(Thrown{});
                 player.turnip = std::nullopt;
             }
             if (hadTurnip && eatPressed)
             {
                 auto turnip = player.turnip.value();
                 player.hunger = std::min(100.0f, player.hunger + 20);
-                SpawnParticles(m_world.GetComponent<Position>(turnip).AsVec(), 5, -10, 10, 5, 10);
-                toRemove.push_back(turnip);
-                tako::Audio::Play(*m_clipEat);
+                events.Emit(Eaten{m_world.GetComponent<Position>(turnip).AsVec()});
+                m_toRemove.push_back(turnip);
                 player.turnip = std::nullopt;
             }
 
-            Physics::Move(m_world, m_level, pos, rigid, tako::Vector2(moveX, moveY) * dt);
+            Physics::Move(m_world, m_moveBatch, m_level, pos, rigid, tako::Vector2(moveX, moveY) * dt);
             if (player.turnip.has_value())
             {
                 auto turnip = player.turnip.value();
@@ -490,109 +1225,59 @@ public:
                 tPos.y = tVec.y;
             }
         });
-        m_world.IterateComps<Plant, SpriteRenderer>([&](Plant& plant, SpriteRenderer& sprite)
+        m_plantTimers.Advance(m_step, [&](tako::Entity plant)
         {
-            plant.growth += dt * plant.growthRate;
-            if (plant.growth > 10)
-            {
-                sprite.sprite = m_plantStates[2];
-            }
-            else if (plant.growth > 5)
-            {
-                sprite.sprite = m_plantStates[1];
-            }
-            else
-            {
-                sprite.sprite = m_plantStates[0];
-            }
-
+            UpdatePlantStage(plant);
         });
 
         m_world.IterateComps<Position, Turnip, RigidBody>([&](Position& position, Turnip& turnip, RigidBody& rigid)
         {
             turnip.speed.y += dt * -30;
             bool deleted = false;
-            std::optional<tako::Entity> killed;
-            Physics::Move(m_world, m_level, position, rigid, turnip.speed * dt,
+            bool hitLevel = false;
+            bool killed = false;
+            Physics::Move(m_world, m_moveBatch, m_level, position, rigid, turnip.speed * dt,
                 [&]()
                 {
                     if (!deleted)
                     {
-                        toRemove.push_back(rigid.entity);
-                        tako::Audio::Play(*m_clipBroke);
+                        m_toRemove.push_back(rigid.entity);
+                        hitLevel = true;
                         deleted = true;
                     }
                 },
                 [&](auto& otherRigid, auto& movement)
                 {
-                    if (!killed && m_world.HasComponent<Enemy>(otherRigid.entity))
+                    if (!killed && (otherRigid.tags & BodyTag::Enemy))
                     {
                         if (!deleted)
                         {
-                            toRemove.push_back(rigid.entity);
+                            m_toRemove.push_back(rigid.entity);
                             deleted = true;
                         }
-
-                        tako::Audio::Play(*m_clipKill);
-                        killed = otherRigid.entity;
+                        // The rabbit turns into a corpse after the step, until then nothing may hit it or be hit by it
+                        otherRigid.tags = 0;
+                        otherRigid.collidesWith = 0;
+                        events.Emit(Killed{otherRigid.entity});
+                        killed = true;
                     }
                 }
             );
             if (deleted)
             {
-                SpawnParticles(position.AsVec(), 8, turnip.speed.x * 0.5f, turnip.speed.x * 2, turnip.speed.y * 0.5f, turnip.speed.y * 2);
-            }
-            if (killed)
-            {
-                auto toKill = killed.value();
-                auto enm = m_world.GetComponent<Enemy>(toKill);
-                auto speed = enm.speed;
-                m_world.RemoveComponent<Enemy>(toKill);
-                m_world.RemoveComponent<RigidBody>(toKill);
-                m_world.GetComponent<SpriteRenderer>(toKill).sprite = enm.direction > 0 ? m_rabbitDead : m_rabbitDeadR;
-                m_world.AddComponent<DeadEnemy>(toKill);
-                m_world.AddComponent<Background>(toKill);
-                m_world.RemoveComponent<Foreground>(toKill);
-                auto& dead = m_world.GetComponent<DeadEnemy>(toKill);
-                dead.speed = speed;
-                dead.groundTime = 0;
-                m_score++;
+                events.Emit(TurnipBroke{position.AsVec(), turnip.speed, hitLevel});
             }
         });
 
-        static float carrotX = 0;
-        m_world.IterateHandle<Position, Carrot>([&](tako::EntityHandle handle)
+        m_world.IterateComps<Position, Carrot, RigidBody>([&](Position& position, Carrot& carrot, RigidBody& rigid)
         {
-            Position& position = m_world.GetComponent<Position>(handle.id);
-            Carrot& carrot = m_world.GetComponent<Carrot>(handle.id);
-            carrotX = position.x;
+            m_carrotX = position.x;
             carrot.displayHealth += (carrot.health - carrot.displayHealth) * dt * 3;
             if (carrot.health <= 0 && carrot.displayHealth < 3)
             {
                 carrot.displayHealth = 0;
-                toRemove.push_back(handle.id);
-                SpawnParticles(position.AsVec(), 64, -20, 20, -10, 50);
-                tako::Audio::Play(*m_clipDeath);
-                if (m_gameState != GameState::GameOver)
-                {
-                    m_gameState = GameState::GameOver;
-                    std::stringstream str;
-                    if (m_score < 25)
-                    {
-                        str << "You weren't able to defend your carrot!\n"
-                            << "Don't let the rabbits reach it!\n";
-                    }
-                    else
-                    {
-                        str << "You killed many hungry rabbits,\n"
-                            << "but keeping it alive is impossible\n";
-                    }
-                    str << "Score: " << m_score << "\n"
-                        << "Thanks for playing!\n"
-                        << "Refresh for restart";
-
-                    m_textGameOver = CreateText(m_drawer, m_font, str.str());
-                }
+                m_toRemove.push_back(rigid.entity);
+                events.Emit(Died{position.AsVec(), GameOverCause::Carrot});
             }
             if (carrot.health > 0)
             {
@@ -600,208 +1285,561 @@ public:
             }
         });
 
-        m_world.IterateComps<Position, RigidBody, Enemy, SpriteRenderer>([&](Position& position, RigidBody& rigid, Enemy& enemy, SpriteRenderer& sprite)
+        UpdateSimulationViews();
+        // Rabbits only collide with carrots, which stay put while they move
+        Physics::Gather(m_world, BodyTag::Carrot, m_carrotBodies);
+        m_lodMoves.clear();
+        m_world.IterateComps<Position, RigidBody, Enemy, AnimatedSprite, InView>([&](Position& position, RigidBody& rigid, Enemy& enemy, AnimatedSprite& animation, InView&)
         {
-            auto grounded = Physics::IsGrounded(m_level, position, rigid);
-            if (grounded)
+            auto visible = InSimulationView(position.AsVec());
+            if (!StepEnemy(events, position, rigid, enemy, animation, visible, dt) && m_enemyLod && !visible)
             {
-                sprite.sprite = enemy.direction > 0 ? m_rabbit : m_rabbitR;
-                if (enemy.groundTime == 0)
-                {
-                    SpawnParticles(position.AsVec() - tako::Vector2(0.0f, rigid.size.y / 2), 5, -7, 7, 40, 60);
-                }
-                enemy.groundTime += dt;
-                enemy.speed = { 0, 0 };
-                if (enemy.groundTime > 2)
-                {
-                    Physics::Move(m_world, m_level, position, rigid, {0, 0.5f });
-                    enemy.speed = { 30 * tako::mathf::sign(carrotX - position.x), rand() % 30 + 20.0f };
-                    enemy.direction = tako::mathf::sign(enemy.speed.x);
-                    auto speedSign = -tako::mathf::sign(enemy.speed.x);
-                    enemy.groundTime = 0;
-                    SpawnParticles(position.AsVec() - tako::Vector2(0.0f, rigid.size.y / 2), 5, 5 * speedSign, 10 * speedSign, 10, 30);
-                    sprite.sprite = enemy.direction > 0 ? m_rabbitJump : m_rabbitJumpR;
-                }
+                // Rabbits leaving together are spread over the slices
+                m_lodMoves.push_back({rigid.entity, int(m_step + m_lodMoves.size()) % enemyLodInterval});
             }
-            else
+        });
+        StepOffViewSlice(events, m_step % enemyLodInterval, std::make_integer_sequence<int, enemyLodInterval>());
+
+        Physics::IntegrateBallistic(m_world, m_corpseBatch, m_level, dt, 80, {12, 12});
+        Physics::IntegrateBallistic(m_world, m_particleBatch, m_level, dt, 50, {1, 1});
+        m_world.IterateComps<Spawner>([&](Spawner& spawn)
+        {
+            spawn.duration -= dt;
+            if (spawn.duration <= 0)
             {
-                sprite.sprite = enemy.direction > 0 ? m_rabbitJump : m_rabbitJumpR;
-                enemy.groundTime = 0;
-                enemy.speed.y -= dt * 20;
+                SpawnRabbit(spawn.x, spawn.y);
+                spawn.duration = SpawnInterval();
             }
-
-            auto destroyed = false;
-            Physics::Move(m_world, m_level, position, rigid, enemy.speed * dt, {},
-                [&](auto& otherRigid, auto& movement)
-                {
-                    if (!destroyed && m_world.HasComponent<Carrot>(otherRigid.entity))
-                    {
-                        destroyed = true;
-                        toRemove.push_back(rigid.entity);
-                        auto& carrot = m_world.GetComponent<Carrot>(otherRigid.entity);
-                        carrot.health = std::max(0.0f, carrot.health - rand() * 1.0f / RAND_MAX * 10 - 15);
-                        tako::Audio::Play(*m_clipHurt);
-                        SpawnParticles(position.AsVec(), 15, -enemy.speed.x, -enemy.speed.x * 1.5f, 0, 20);
-
-                    }
-                }
-            );
         });
+        // Off view rabbits advanced theirs in their slice
+        auto advance = [&](AnimatedSprite& animation)
+        {
+            m_animations.Advance(animation, dt);
+        };
+        m_world.IterateComps<AnimatedSprite, Player>([&](AnimatedSprite& animation, Player&) { advance(animation); });
+        m_world.IterateComps<AnimatedSprite, InView>([&](AnimatedSprite& animation, InView&) { advance(animation); });
+        m_world.IterateComps<AnimatedSprite, DeadEnemy>([&](AnimatedSprite& animation, DeadEnemy&) { advance(animation); });
+        // Tags only change once every loop over them is done, a tag count can reach a new peak like a spawn
+        m_spawned |= !m_lodMoves.empty();
+        for (auto& move : m_lodMoves)
+        {
+            auto& enemy = m_world.GetComponent<Enemy>(move.entity);
+            RemoveLodTag(move.entity, enemy.lodSlice, std::make_integer_sequence<int, enemyLodInterval>());
+            AddLodTag(move.entity, move.slice, std::make_integer_sequence<int, enemyLodInterval>());
+            enemy.lodSlice = move.slice;
+        }
+        ApplyEvents();
+        // Replayed frames were counted when they were predicted, the flag stays up for the next live frame
+        if (m_spawned && !m_replaying)
+        {
+            m_census.Take(m_world);
+            m_spawned = false;
+        }
+        for (auto ent : m_toRemove)
+        {
+            m_world.Delete(ent);
+        }
+        m_toRemove.clear();
+    }
 
-        m_world.IterateComps<Position, DeadEnemy>([&](Position& pos, DeadEnemy& enm)
+    // Runs the effects of everything the systems reported, in a fixed order so replays produce the same world
+    void ApplyEvents()
+    {
+        m_events.Consume<Stepped>([&](Stepped& event)
+        {
+            PlaySound(m_clipStep);
+            SpawnParticles(event.position - tako::Vector2(0, 5), 1, -5 * event.direction, -10 * event.direction, 10, 20);
+        });
+        m_events.Consume<Jumped>([&](Jumped& event)
+        {
+            PlaySound(m_clipJump);
+        });
+        m_events.Consume<Harvested>([&](Harvested& event)
+        {
+            m_spawned = true;
+            PlaySound(m_harvest);
+            SpawnParticles({event.position.x, event.position.y - 3}, 5, -15, 15, 5, 40);
+            m_world.GetComponent<Player>(event.player).turnip = m_heldTurnipPrefab.Instantiate(m_world, [&](tako::Entity turnip, Position& tPos, SpriteRenderer& tRen, Foreground& f)
+            {
+                tPos = {event.position.x, event.position.y};
+                tRen.sprite = m_turnip;
+            });
+        });
+        m_events.Consume<Thrown>([&](Thrown& event)
+        {
+            PlaySound(m_clipThrow);
+        });
+        m_events.Consume<Eaten>([&](Eaten& event)
+        {
+            PlaySound(m_clipEat);
+            SpawnParticles(event.position, 5, -10, 10, 5, 10);
+        });
+        m_events.Consume<TurnipBroke>([&](TurnipBroke& event)
         {
-            auto target = pos.AsVec() + enm.speed * dt;
-            enm.speed.y -= dt * 80;
-            Rect tRect(target, {12, 12});
-            if (m_level->Overlap(tRect))
+            if (!InSimulationView(event.position))
             {
-                enm.speed /= -4;
+                return;
             }
-            else
+            if (event.hitLevel)
             {
-                pos.x = target.x;
-                pos.y = target.y;
+                PlaySound(m_clipBroke);
             }
+            SpawnParticles(event.position, 8, event.speed.x * 0.5f, event.speed.x * 2, event.speed.y * 0.5f, event.speed.y * 2);
         });
-        m_world.IterateComps<Position, Particle>([&](Position& pos, Particle& part)
+        m_events.Consume<Killed>([&](Killed& event)
         {
-            auto target = pos.AsVec() + part.speed * dt;
-            part.speed.y -= dt * 50;
-            Rect tRect(target, {1, 1});
-            if (m_level->Overlap(tRect))
+            if (InSimulationView(m_world.GetComponent<Position>(event.enemy).AsVec()))
             {
-                part.speed /= -4;
+                PlaySound(m_clipKill);
             }
-            else
+            auto enm = m_world.GetComponent<Enemy>(event.enemy);
+            RemoveLodTag(event.enemy, enm.lodSlice, std::make_integer_sequence<int, enemyLodInterval>());
+            m_world.RemoveComponent<Enemy>(event.enemy);
+            m_world.RemoveComponent<RigidBody>(event.enemy);
+            auto& animation = m_world.GetComponent<AnimatedSprite>(event.enemy);
+            m_animations.Play(animation, AnimationClip::RabbitDead);
+            animation.flip = enm.direction <= 0;
+            m_world.AddComponent<DeadEnemy>(event.enemy);
+            m_world.AddComponent<Background>(event.enemy);
+            m_world.RemoveComponent<Foreground>(event.enemy);
+            auto& dead = m_world.GetComponent<DeadEnemy>(event.enemy);
+            dead.speed = enm.speed;
+            dead.groundTime = 0;
+            m_score++;
+        });
+        m_events.Consume<Landed>([&](Landed& event)
+        {
+            SpawnParticles(event.position, 5, -7, 7, 40, 60);
+        });
+        m_events.Consume<Hopped>([&](Hopped& event)
+        {
+            auto speedSign = -event.direction;
+            SpawnParticles(event.position, 5, 5 * speedSign, 10 * speedSign, 10, 30);
+        });
+        m_events.Consume<CarrotHurt>([&](CarrotHurt& event)
+        {
+            auto& carrot = m_world.GetComponent<Carrot>(event.carrot);
+            carrot.health = std::max(0.0f, carrot.health - m_random.Value() * 10 - 15);
+            // The only cue that the carrot is attacked, it plays wherever the carrot is
+            PlaySound(m_clipHurt);
+            if (InSimulationView(event.position))
             {
-                pos.x = target.x;
-                pos.y = target.y;
+                SpawnParticles(event.position, 15, -event.speed.x, -event.speed.x * 1.5f, 0, 20);
             }
         });
-        m_world.IterateComps<Spawner>([&](Spawner& spawn)
+        m_events.Consume<Died>([&](Died& event)
         {
-            spawn.duration -= dt;
-            if (spawn.duration <= 0)
+            SpawnParticles(event.position, 64, -20, 20, -10, 50);
+            PlaySound(m_clipDeath);
+            if (m_gameState != GameState::GameOver)
             {
-                SpawnRabbit(spawn.x, spawn.y);
-                spawn.duration = rand() * 1.0f / RAND_MAX * 2 + 10 / (1 + m_score / 25.0f);
+                m_gameState = GameState::GameOver;
+                m_gameOverCause = event.cause;
             }
         });
-        m_world.IterateComps<Position, Player>([&](Position& pos, Player& player)
+    }
+
+    void SaveState(SimulationState& state)
+    {
+        state.world.Reserve(m_capacityHints, m_capacityHints.Get<Position>() + m_capacityHints.Get<Spawner>());
+        AddShapes(state.world);
+        state.world.Save(m_world);
+        state.gameState = m_gameState;
+        state.gameOverCause = m_gameOverCause;
+        state.score = m_score;
+        state.random = m_random;
+        state.carrotX = m_carrotX;
+        state.stepInterval = m_stepInterval;
+        state.step = m_step;
+    }
+
+    // Every combination of components an entity can be in, a killed rabbit ends up shaped like a dead one
+    void AddShapes(SimulationWorld& world)
+    {
+        m_playerPrefab.AddShape(world);
+        m_carrotPrefab.AddShape(world);
+        m_particlePrefab.AddShape(world);
+        m_plantPrefab.AddShape(world);
+        m_rabbitPrefab.AddShape(world);
+        AddOffViewShapes(world, std::make_integer_sequence<int, enemyLodInterval>());
+        m_deadRabbitPrefab.AddShape(world);
+        m_heldTurnipPrefab.AddShape(world);
+        world.AddShape<Position, SpriteRenderer, Foreground, RigidBody, Turnip>();
+        m_spawnerPrefab.AddShape(world);
+    }
+
+    template<int... Slices>
+    void AddOffViewShapes(SimulationWorld& world, std::integer_sequence<int, Slices...>)
+    {
+        (world.AddShape<Position, AnimatedSprite, RigidBody, Enemy, Foreground, OffView<Slices>>(), ...);
+    }
+
+    // Rebuilds the world from scratch, so the entities iterate in the saved order whatever happened since
+    void LoadState(SimulationState& state)
+    {
+        m_world = tako::World();
+        state.world.Restore(m_world);
+        m_world.IterateComps<RigidBody>([&](RigidBody& rigid)
         {
-           m_cameraTarget = FitMapBound(m_level->MapBounds(), pos.AsVec(), m_cameraSize);
+            rigid.entity = state.world.Restored(rigid.entity);
+        });
+        m_world.IterateComps<Temporary>([&](Temporary& tmp)
+        {
+            tmp.entity = state.world.Restored(tmp.entity);
+        });
+        m_world.IterateComps<Player>([&](Player& player)
+        {
+            if (player.turnip)
+            {
+                player.turnip = state.world.Restored(player.turnip.value());
+            }
+        });
+        m_gameState = state.gameState;
+        m_gameOverCause = state.gameOverCause;
+        m_score = state.score;
+        m_random = state.random;
+        m_carrotX = state.carrotX;
+        m_stepInterval = state.stepInterval;
+        m_step = state.step;
+        // The wheel isn't saved, the world was rebuilt anyway and the pending stages follow from the plants
+        m_plantTimers.Clear(m_step);
+        m_world.IterateHandle<Plant, SpriteRenderer>([&](tako::EntityHandle handle)
+        {
+            UpdatePlantStage(handle.id);
         });
-        m_cameraPos += (m_cameraTarget - m_cameraPos) * dt * 2;
-        m_cameraPos = FitMapBound(m_level->MapBounds(), m_cameraPos, m_cameraSize);
     }
 
-    void SpawnRabbit(int x, int y)
+    // Shows the stage a plant is in and schedules the next one, a plant is only touched again when its sprite changes
+    void UpdatePlantStage(tako::Entity entity)
+    {
+        auto& plant = m_world.GetComponent<Plant>(entity);
+        auto stage = plant.Stage(m_step);
+        m_world.GetComponent<SpriteRenderer>(entity).sprite = m_plantStates[stage];
+        plant.stageTimer = stage < 2 ? m_plantTimers.Schedule(plant.plantedAt + plant.StageSteps(stage + 1), entity) : TimerHandle{};
+    }
+
+    // Frames stepped again after a rollback were already presented, their sounds must not play twice
+    void SetReplaying(bool replaying)
+    {
+        m_replaying = replaying;
+    }
+
+    // Returns whether the rabbit reached the carrot and is gone at the end of the step
+    bool StepEnemy(GameEvents::Buffer& events, Position& position, RigidBody& rigid, Enemy& enemy, AnimatedSprite& animation, bool visible, float elapsed)
     {
-        auto enemy = m_world.Create<Position, SpriteRenderer, RigidBody, Enemy, Foreground>();
-        auto& pos = m_world.GetComponent<Position>(enemy);
-        pos.x = x * 16 + 8;
-        pos.y = y * 16 + 8;
-        auto& renderer = m_world.GetComponent<SpriteRenderer>(enemy);
-        renderer.size = { 12, 12};
-        renderer.sprite = m_rabbitJump;
-        auto& rigid = m_world.GetComponent<RigidBody>(enemy);
-        rigid.size = { 12, 12 };
-        rigid.entity = enemy;
-        auto& en = m_world.GetComponent<Enemy>(enemy);
-        en.speed = {0, 0};
-        en.groundTime = 0;
-        m_world.IterateComps<Position, Carrot>([&](Position& cPos, Carrot& c)
+        enemy.steppedAt = m_step;
+        auto grounded = Physics::IsGrounded(m_level, position, rigid);
+        if (grounded)
         {
-            en.direction = cPos.x < pos.x ? -1 : 1;
-            renderer.sprite = en.direction > 0 ? m_rabbitJump : m_rabbitJumpR;
-        });
+            m_animations.Play(animation, AnimationClip::RabbitIdle);
+            if (enemy.groundTime == 0 && visible)
+            {
+                events.Emit(Landed{position.AsVec() - tako::Vector2(0.0f, rigid.size.y / 2)});
+            }
+            enemy.groundTime += elapsed;
+            enemy.speed = { 0, 0 };
+            if (enemy.groundTime > 2)
+            {
+                Physics::Move(m_world, m_moveBatch, m_level, position, rigid, {0, 0.5f });
+                auto step = m_navigation.Lookup(position.AsVec() - tako::Vector2(0.0f, rigid.size.y / 2));
+                if (step)
+                {
+                    enemy.speed = step->impulse;
+                }
+                else
+                {
+                    enemy.speed = { 30 * tako::mathf::sign(m_carrotX - position.x), m_random.Int(30) + 20.0f };
+                }
+                enemy.direction = tako::mathf::sign(enemy.speed.x);
+                enemy.groundTime = 0;
+                if (visible)
+                {
+                    events.Emit(Hopped{position.AsVec() - tako::Vector2(0.0f, rigid.size.y / 2), enemy.direction});
+                }
+                m_animations.Play(animation, AnimationClip::RabbitJump);
+            }
+        }
+        else
+        {
+            m_animations.Play(animation, AnimationClip::RabbitJump);
+            enemy.groundTime = 0;
+            enemy.speed.y -= elapsed * 20;
+        }
+        animation.flip = enemy.direction <= 0;
+
+        auto destroyed = false;
+        Physics::MoveAgainst(m_carrotBodies, m_level, position, rigid, enemy.speed * elapsed, {},
+            [&](auto& otherRigid, auto& movement)
+            {
+                if (!destroyed && (otherRigid.tags & BodyTag::Carrot))
+                {
+                    destroyed = true;
+                    m_toRemove.push_back(rigid.entity);
+                    events.Emit(CarrotHurt{otherRigid.entity, position.AsVec(), enemy.speed});
+                }
+            }
+        );
+        return destroyed;
     }
 
-    void Draw(tako::PixelArtDrawer* drawer)
+    // Steps the off view rabbits whose turn it is with the time they missed, the ones back in view rejoin the others
+    template<int... Slices>
+    void StepOffViewSlice(GameEvents::Buffer& events, int slice, std::integer_sequence<int, Slices...>)
     {
-        if (m_bitmappedScore != m_score)
+        auto step = [&](Position& position, RigidBody& rigid, Enemy& enemy, AnimatedSprite& animation)
         {
-            if (m_scoreText)
+            auto visible = InSimulationView(position.AsVec());
+            auto elapsed = (m_step - enemy.steppedAt) * simulationStep;
+            if (StepEnemy(events, position, rigid, enemy, animation, visible, elapsed))
+            {
+                return;
+            }
+            m_animations.Advance(animation, elapsed);
+            if (visible || !m_enemyLod)
             {
-                delete m_scoreText;
-                m_scoreText = nullptr;
+                m_lodMoves.push_back({rigid.entity, -1});
             }
-            auto bitmap = m_font->RenderText(std::to_string(m_score), 1);
-            m_scoreText = drawer->CreateTexture(bitmap);
-            m_scoreSize = tako::Vector2(bitmap.Width(), bitmap.Height());
-            m_bitmappedScore = m_score;
+        };
+        ((slice == Slices ? m_world.IterateComps<Position, RigidBody, Enemy, AnimatedSprite, OffView<Slices>>(
+            [&](Position& position, RigidBody& rigid, Enemy& enemy, AnimatedSprite& animation, OffView<Slices>&)
+            {
+                step(position, rigid, enemy, animation);
+            }) : void()), ...);
+    }
+
+    template<int... Slices>
+    void AddLodTag(tako::Entity entity, int slice, std::integer_sequence<int, Slices...>)
+    {
+        if (slice < 0)
+        {
+            m_world.AddComponent<InView>(entity);
         }
-        m_cameraSize = drawer->GetCameraViewSize();
-        drawer->Clear();
+        ((slice == Slices ? m_world.AddComponent<OffView<Slices>>(entity) : void()), ...);
+    }
 
-        if (m_gameState == GameState::PressAny)
+    template<int... Slices>
+    void RemoveLodTag(tako::Entity entity, int slice, std::integer_sequence<int, Slices...>)
+    {
+        if (slice < 0)
         {
-            drawer->SetCameraPosition({0, 0});
-            drawer->DrawImage(-m_textPressAny.size.x/2, m_textPressAny.size.y/2, m_textPressAny.size.x, m_textPressAny.size.y, m_textPressAny.texture);
-            return;
+            m_world.RemoveComponent<InView>(entity);
         }
-        if (m_gameState == GameState::StartMenu)
+        ((slice == Slices ? m_world.RemoveComponent<OffView<Slices>>(entity) : void()), ...);
+    }
+
+    // Rabbits out of every player's view are stepped at a reduced rate, off for comparing against full rate
+    void SetSimulationLod(bool enabled)
+    {
+        m_enemyLod = enabled;
+    }
+
+    void UpdateSimulationViews()
+    {
+        m_simulationViews.clear();
+        m_world.IterateComps<Position, Player>([&](Position& pos, Player& player)
         {
-            drawer->SetCameraPosition(m_cameraSize/2);
-            drawer->DrawImage((m_cameraSize.x - m_textTitle.size.x * 2 ) / 2, m_cameraSize.y - 16, m_textTitle.size.x * 2, m_textTitle.size.y * 2, m_textTitle.texture);
-            drawer->DrawSprite((m_cameraSize.x - m_textTitle.size.x * 2 ) / 2 - 4 - 12, m_cameraSize.y - 16, 12, 12, m_rabbit);
-            drawer->DrawImage(m_cameraSize.x - (m_cameraSize.x - m_textTitle.size.x * 2 ) / 2 + 2 + 4, m_cameraSize.y - 18, 12, 12, m_turnipUI);
-            drawer->DrawImage(4, m_textCredits.size.y + 4, m_textCredits.size.x, m_textCredits.size.y, m_textCredits.texture);
-            drawer->SetCameraPosition({0, 0});
-            drawer->DrawImage(-m_textControls.size.x/2, m_textControls.size.y/2, m_textControls.size.x, m_textControls.size.y, m_textControls.texture);
-            return;
+            m_simulationViews.emplace_back(pos.AsVec(), tako::Vector2(simulationViewWidth, simulationViewHeight));
+        });
+    }
+
+    // Decided from player positions only, so every peer skips the same effects
+    bool InSimulationView(tako::Vector2 position)
+    {
+        for (auto& view : m_simulationViews)
+        {
+            if (Rect::Overlap(view, Rect(position, {0, 0})))
+            {
+                return true;
+            }
         }
-        if (m_gameState == GameState::Starting)
+        return false;
+    }
+
+    void PlaySound(tako::AudioClip* clip)
+    {
+        if (!m_replaying && clip)
         {
-            return;
+            m_sound.Play(clip);
         }
+    }
 
-        drawer->SetCameraPosition(m_cameraPos);
-        m_level->Draw(drawer);
-        m_world.IterateComps<Position, RectangleRenderer>([&](Position& pos, RectangleRenderer& rect)
+    float SpawnInterval()
+    {
+        return m_random.Value() * 2 + 10 / (1 + m_score / 25.0f);
+    }
+
+    void SpawnRabbit(int x, int y)
+    {
+        m_spawned = true;
+        m_rabbitPrefab.Instantiate(m_world, [&](tako::Entity enemy, Position& pos, AnimatedSprite& animation, RigidBody& rigid, Enemy& en, Foreground& f, InView& v)
         {
-            drawer->DrawRectangle(pos.x - rect.size.x / 2, pos.y + rect.size.y / 2, rect.size.x, rect.size.y,  rect.color);
+            pos = {x * 16 + 8.0f, y * 16 + 8.0f};
+            rigid.entity = enemy;
+            m_world.IterateComps<Position, Carrot>([&](Position& cPos, Carrot& c)
+            {
+                en.direction = cPos.x < pos.x ? -1 : 1;
+                animation.flip = en.direction < 0;
+            });
         });
-        m_world.IterateComps<Position, SpriteRenderer, Background>([&](Position& pos, SpriteRenderer& sprite, Background& b)
+    }
+
+    // Title, icons, controls and credits composed into one screen sized texture
+    Text CreateMenu(tako::PixelArtDrawer* drawer, tako::Vector2 size)
+    {
+        int width = size.x;
+        int height = size.y;
+        tako::Bitmap bitmap(width, height);
+        FillBitmap(bitmap, 0, 0, width, height, {0, 0, 0, 0});
+        auto title = m_font->RenderText("Bunny Plague", 1);
+        int titleX = (width - title.Width() * 2) / 2;
+        BlitBitmap(bitmap, titleX, 16, title.Width() * 2, title.Height() * 2, title, 0, 0, title.Width(), title.Height());
+        auto rabbit = m_resources.Bitmap("/Rabbit.png");
+        BlitBitmap(bitmap, titleX - 4 - 12, 16, 12, 12, *rabbit, 0, 0, 12, 12);
+        auto turnip = m_resources.Bitmap("/TurnipUI.png");
+        BlitBitmap(bitmap, width - titleX + 2 + 4, 18, 12, 12, *turnip, 0, 0, turnip.Width(), turnip.Height());
+        auto credits = m_font->RenderText("Made in 48 hours by Malai\nLudum Dare 46 - Keep it alive", 1);
+        BlitBitmap(bitmap, 4, height - credits.Height() - 4, credits);
+        auto controls = m_font->RenderText("WASD - Move/Jump\n L/C - Pickup/Throw\n K/X - Pickup/Eat", 1);
+        BlitBitmap(bitmap, (width - controls.Width()) / 2, (height - controls.Height()) / 2, controls);
+        return CreateText(drawer, bitmap);
+    }
+
+    Text CreateGameOverText(tako::PixelArtDrawer* drawer, GameOverCause cause, int score)
+    {
+        std::pmr::string str(&m_drawArena);
+        if (cause == GameOverCause::Hunger)
         {
-            drawer->DrawSprite(pos.x - sprite.size.x / 2, pos.y + sprite.size.y / 2, sprite.size.x, sprite.size.y, sprite.sprite);
-        });
-        m_world.IterateComps<Position, SpriteRenderer, Foreground>([&](Position& pos, SpriteRenderer& sprite, Foreground& f)
+            str += score < 25
+                ? "You weren't able to keep yourself alive!\n"
+                  "Eat turnips to satisfy your hunger!\n"
+                : "You killed many hungry rabbits,\n"
+                  "but you exhausted out of hunger!\n";
+        }
+        else
+        {
+            str += score < 25
+                ? "You weren't able to defend your carrot!\n"
+                  "Don't let the rabbits reach it!\n"
+                : "You killed many hungry rabbits,\n"
+                  "but keeping it alive is impossible\n";
+        }
+        str += "Score: ";
+        AppendNumber(str, score);
+        str += "\n"
+               "Thanks for playing!\n"
+               "Press a button to restart";
+        return CreateText(drawer, m_font, str);
+    }
+
+    // Only reads the published render frame and textures owned by Draw, so it can run while the next Update simulates.
+    // The view size of the drawer goes back to Update, the frames published from then on are captured for it.
+    // The caller samples the buttons for the late latch right before drawing
+    void Draw(tako::PixelArtDrawer* drawer, PlayerInput buttons)
+    {
+        m_renderFrames.Read([&](const RenderFrame& frame)
         {
-            drawer->DrawSprite(pos.x - sprite.size.x / 2, pos.y + sprite.size.y / 2, sprite.size.x, sprite.size.y, sprite.sprite);
+            DrawFrame(drawer, frame, Latch(frame, buttons, InputLatency::Clock::now()));
         });
-        drawer->SetCameraPosition(m_cameraSize/2);
-        if (m_gameState != GameState::GameOver) {
-            if (m_scoreText) {
-                drawer->DrawImage(m_cameraSize.x - 8 - 4, m_cameraSize.y - 3, 8, 8, m_rabbitUI);
-                drawer->DrawImage(m_cameraSize.x - m_scoreSize.x - 8 - 4 - 4, m_cameraSize.y - 4, m_scoreSize.x,
-                                  m_scoreSize.y, m_scoreText);
+    }
+
+    // Presents a frame to the latency tracking. With the late latch on the local player is moved by the next step
+    // as far as it would have come with buttons by now, and the camera takes the last smoothing step towards it.
+    // The buttons are sampled for the tracking either way so both modes count from the same point
+    LatchedView Latch(const RenderFrame& frame, PlayerInput buttons, InputLatency::Clock::time_point now)
+    {
+        LatchedView view{frame.camera};
+        m_latency.Sample(buttons, now);
+        bool latched = m_lateLatch && frame.playerItem >= 0 && frame.state == GameState::InGame;
+        if (latched)
+        {
+            float moveX = 0;
+            if (buttons & InputButton::Left)
+            {
+                moveX -= playerWalkSpeed;
+            }
+            if (buttons & InputButton::Right)
+            {
+                moveX += playerWalkSpeed;
             }
+            bool flip = frame.playerFlip;
+            if (moveX != 0)
+            {
+                flip = moveX > 0;
+            }
+            float speed = playerAcceleration * moveX + (1 - playerAcceleration) * frame.playerSpeed;
+            view.item = frame.playerItem;
+            view.player = frame.items[frame.playerItem];
+            view.player.position.x += speed * frame.sinceStep;
+            view.player.sprite = frame.playerSprites[flip];
+            auto target = FitMapBound(frame.mapBounds, view.player.position, frame.viewSize);
+            view.camera = FitMapBound(frame.mapBounds, frame.cameraFrom + (target - frame.cameraFrom) * frame.cameraBlend, frame.viewSize);
+        }
+        m_latency.Present(frame.inputSerial, latched, now);
+        return view;
+    }
 
-            float carrotHealth = 0;
-            for (auto[carrot] : m_world.Iter<Carrot>()) {
-                carrotHealth = carrot.displayHealth;
-                break;
+    void DrawFrame(tako::PixelArtDrawer* drawer, const RenderFrame& frame, const LatchedView& view)
+    {
+        m_drawArena.Reset();
+        if (frame.state != GameState::GameOver)
+        {
+            m_textGameOverCause = GameOverCause::None;
+        }
+        else if (m_textGameOverCause != frame.gameOverCause)
+        {
+            if (m_textGameOver.texture)
+            {
+                delete m_textGameOver.texture;
             }
-            drawer->DrawImage(4, m_cameraSize.y - 4, 8, 8, m_hearthUI);
-            drawer->DrawRectangle(4 + 10, m_cameraSize.y - 4, 32, 8, {255, 255, 255, 255});
-            drawer->DrawRectangle(5 + 10, m_cameraSize.y - 5, 30, 6, {0, 0, 0, 255});
-            drawer->DrawRectangle(6 + 10, m_cameraSize.y - 6, 28 * carrotHealth / 100, 4, {255, 255, 255, 255});
+            m_textGameOver = CreateGameOverText(drawer, frame.gameOverCause, frame.score);
+            m_textGameOverCause = frame.gameOverCause;
+        }
+        if (frame.assetVersion != m_drawnAssetVersion)
+        {
+            m_hud.Invalidate();
+            m_menuSize = {};
+            m_drawnAssetVersion = frame.assetVersion;
+        }
+        m_drawnViewSize.store(drawer->GetCameraViewSize(), std::memory_order_relaxed);
+        auto viewSize = frame.viewSize;
+        drawer->Clear();
 
-            float playerHunger = 0;
-            for (auto[player] : m_world.Iter<Player>()) {
-                playerHunger = player.displayedHunger;
-                break;
+        if (frame.state == GameState::PressAny)
+        {
+            drawer->SetCameraPosition({0, 0});
+            drawer->DrawImage(-m_textPressAny.size.x/2, m_textPressAny.size.y/2, m_textPressAny.size.x, m_textPressAny.size.y, m_textPressAny.texture);
+            return;
+        }
+        if (frame.state == GameState::StartMenu)
+        {
+            if (m_menuSize.x != viewSize.x || m_menuSize.y != viewSize.y)
+            {
+                if (m_textMenu.texture)
+                {
+                    delete m_textMenu.texture;
+                }
+                m_textMenu = CreateMenu(drawer, viewSize);
+                m_menuSize = viewSize;
             }
-            constexpr auto offY = 10;
-            drawer->DrawImage(4, m_cameraSize.y - 4 - offY, 8, 8, m_turnipUI);
-            drawer->DrawRectangle(4 + 10, m_cameraSize.y - 4 - offY, 32, 8, {255, 255, 255, 255});
-            drawer->DrawRectangle(5 + 10, m_cameraSize.y - 5 - offY, 30, 6, {0, 0, 0, 255});
-            drawer->DrawRectangle(6 + 10, m_cameraSize.y - 6 - offY, 28 * playerHunger / 100, 4, {255, 255, 255, 255});
+            drawer->SetCameraPosition(viewSize/2);
+            drawer->DrawImage(0, viewSize.y, m_textMenu.size.x, m_textMenu.size.y, m_textMenu.texture);
+            return;
+        }
+        if (frame.state == GameState::Starting)
+        {
+            return;
+        }
+
+        drawer->SetCameraPosition(view.camera);
+        SubmitRenderItems(drawer, frame.tiles);
+        SubmitRenderItems(drawer, frame.items, view.item, view.player);
+        drawer->SetCameraPosition(viewSize/2);
+        if (frame.state != GameState::GameOver) {
+            m_hud.Draw(drawer, viewSize, frame.carrotHealth, frame.playerHunger, frame.score);
         }
         else
         {
-            drawer->DrawRectangle(0, m_cameraSize.y, m_cameraSize.x, m_cameraSize.y, { 0, 0, 0, 160});
+            drawer->DrawRectangle(0, viewSize.y, viewSize.x, viewSize.y, { 0, 0, 0, 160});
             drawer->SetCameraPosition({0, 0});
             drawer->DrawImage(-m_textGameOver.size.x/2, m_textGameOver.size.y/2, m_textGameOver.size.x, m_textGameOver.size.y, m_textGameOver.texture);
         }
@@ -811,46 +1849,92 @@ private:
     tako::World m_world;
     tako::Vector2 m_cameraPos;
     tako::Vector2 m_cameraTarget;
-    tako::Vector2 m_cameraSize;
+    tako::Vector2 m_cameraFrom;
+    float m_cameraBlend = 0;
+    // Update's copy of the view size, Draw stores the size of its drawer in m_drawnViewSize
+    tako::Vector2 m_cameraSize{viewWidth, viewHeight};
+    std::atomic<tako::Vector2> m_drawnViewSize{tako::Vector2(viewWidth, viewHeight)};
+    tako::U32 m_assetVersion = 0;
+    tako::U32 m_drawnAssetVersion = 0;
     tako::Sprite* m_carrot;
+    AnimationSet m_animations = CreateAnimations();
+    // What every spawned entity starts out with, sprites that come from assets are set per instance
+    Prefab<Position, AnimatedSprite, RigidBody, Player, Foreground> m_playerPrefab{{},
+        {{12, 12}, AnimationClip::PlayerIdle, 0, true, 0}, {{12, 12}, {}, BodyTag::Player, 0}, {0, {0, 0}, 100, 0, 0, 1, 0, std::nullopt}, {}};
+    Prefab<Position, SpriteRenderer, Background, Carrot, RigidBody> m_carrotPrefab{{},
+        {{16, 32}, nullptr}, {}, {100, 0}, {{16, 32}, {}, BodyTag::Carrot, 0}};
+    Prefab<Position, RectangleRenderer, Temporary, Particle> m_particlePrefab{{}, {{1, 1}, {255, 255, 255, 255}}, {}, {}};
+    Prefab<Position, SpriteRenderer, Plant, Foreground> m_plantPrefab{{}, {{16, 16}, nullptr}, {}, {}};
+    Prefab<Position, AnimatedSprite, RigidBody, Enemy, Foreground, InView> m_rabbitPrefab{{},
+        {{12, 12}, AnimationClip::RabbitJump, 0, false, 0}, {{12, 12}, {}, BodyTag::Enemy, BodyTag::Carrot}, {{0, 0}, 0, 0, 0, -1}, {}, {}};
+    Prefab<Position, AnimatedSprite, DeadEnemy, Background> m_deadRabbitPrefab{{}, {{12, 12}, AnimationClip::RabbitDead, 0, false, 0}, {}, {}};
+    Prefab<Position, SpriteRenderer, Foreground> m_heldTurnipPrefab{{}, {{8, 8}, nullptr}, {}};
+    Prefab<Spawner> m_spawnerPrefab{{}};
     tako::Texture* m_turnipUI;
     tako::Texture* m_hearthUI;
     tako::Texture* m_rabbitUI;
     tako::Sprite* m_turnip;
-    tako::Sprite* m_playerJump;
-    tako::Sprite* m_player;
-    tako::Sprite* m_playerWalk1;
-    tako::Sprite* m_playerWalk2;
-    tako::Sprite* m_playerR;
-    tako::Sprite* m_playerWalk1R;
-    tako::Sprite* m_playerWalk2R;
-    tako::Sprite* m_rabbit;
-    tako::Sprite* m_rabbitJump;
-    tako::Sprite* m_rabbitDead;
-    tako::Sprite* m_rabbitR;
-    tako::Sprite* m_rabbitJumpR;
-    tako::Sprite* m_rabbitDeadR;
     tako::AudioClip* m_clipStep;
     tako::AudioClip* m_clipEat;
     tako::AudioClip* m_clipThrow;
     tako::AudioClip* m_clipBroke;
     tako::AudioClip* m_clipKill;
     tako::AudioClip* m_harvest;
-    tako::AudioClip* m_clipMusic;
     tako::AudioClip* m_clipHurt;
     tako::AudioClip* m_clipDeath;
     tako::AudioClip* m_clipJump;
-    tako::Vector2 m_scoreSize;
-    tako::Texture* m_scoreText = nullptr;
     tako::Font* m_font;
+    AssetArchive m_archive;
+    // Before everything holding resources, so it goes away after them
+    ResourceCache m_resources{m_archive};
+    Resource<tako::AudioClip> m_music;
     Text m_textPressAny;
-    Text m_textTitle;
-    Text m_textControls;
-    Text m_textGameOver;
-    Text m_textCredits;
-    int m_bitmappedScore = -1;
+    Text m_textMenu = {};
+    tako::Vector2 m_menuSize;
+    Text m_textGameOver = {};
+    GameOverCause m_textGameOverCause = GameOverCause::None;
+    Hud m_hud;
     int m_score = 0;
-    std::array<tako::Sprite*, 3> m_plantStates;
+    std::array<tako::Sprite*, 3> m_plantStates = {};
     tako::PixelArtDrawer* m_drawer;
-    Level* m_level;
+    Level* m_level = nullptr;
+    NavigationField m_navigation;
+    ChunkStreamer m_streamer;
+    std::vector<tako::Vector2> m_streamCenters;
+    SoundMixer m_sound;
+    SimulationState m_startState;
+    std::vector<ChunkRecord> m_startRecords;
+    std::vector<ImageAsset> m_images;
+    std::vector<ClipAsset> m_clips;
+    AssetWatcher m_assetWatcher;
+    float m_gameOverTime = 0;
+    GameOverCause m_gameOverCause = GameOverCause::None;
+    Random m_random;
+    float m_carrotX = 0;
+    float m_stepInterval = 0.6f;
+    bool m_streaming = true;
+    bool m_replaying = false;
+    int m_localSlot = 0;
+    PlayerInput m_localInput = 0;
+    InputLatency m_latency;
+    bool m_lateLatch = false;
+    float m_stepTime = 0;
+    GameEvents m_events;
+    SimulationCensus m_census;
+    SimulationCounts m_capacityHints = DefaultCapacityHints();
+    bool m_spawned = false;
+    tako::U32 m_step = 0;
+    TimerWheel<tako::Entity> m_plantTimers;
+    bool m_enemyLod = true;
+    std::vector<Rect> m_simulationViews;
+    std::vector<LodMove> m_lodMoves;
+    BodyBatch m_carrotBodies;
+    // Scratch of the physics passes, kept per game and reserved up front so bursts don't grow them mid step
+    BodyBatch m_moveBatch;
+    BallisticBatch<Particle> m_particleBatch;
+    BallisticBatch<DeadEnemy> m_corpseBatch;
+    DoubleBuffered<RenderFrame> m_renderFrames;
+    FrameArena m_frameArena;
+    FrameArena m_drawArena{16 * 1024};
+    std::pmr::vector<tako::Entity> m_toRemove{&m_frameArena};
 };
\ No newline at end of file
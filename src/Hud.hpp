@@ -0,0 +1,136 @@
+#pragma once
+#include "Tako.hpp"
+#include "Font.hpp"
+#include "ResourceCache.hpp"
+#include <algorithm>
+#include <charconv>
+
+// Nearest neighbour copy of a source region onto a target region, fully transparent source pixels are skipped
+void BlitBitmap(tako::Bitmap& target, int x, int y, int w, int h, const tako::Bitmap& source, int sx, int sy, int sw, int sh)
+{
+    for (int ty = std::max(0, y); ty < std::min(target.Height(), y + h); ty++)
+    {
+        for (int tx = std::max(0, x); tx < std::min(target.Width(), x + w); tx++)
+        {
+            auto color = source.GetPixel(sx + (tx - x) * sw / w, sy + (ty - y) * sh / h);
+            if (color.a > 0)
+            {
+                target.SetPixel(tx, ty, color);
+            }
+        }
+    }
+}
+
+void BlitBitmap(tako::Bitmap& target, int x, int y, const tako::Bitmap& source)
+{
+    BlitBitmap(target, x, y, source.Width(), source.Height(), source, 0, 0, source.Width(), source.Height());
+}
+
+void FillBitmap(tako::Bitmap& target, int x, int y, int w, int h, tako::Color color)
+{
+    for (int ty = std::max(0, y); ty < std::min(target.Height(), y + h); ty++)
+    {
+        for (int tx = std::max(0, x); tx < std::min(target.Width(), x + w); tx++)
+        {
+            target.SetPixel(tx, ty, color);
+        }
+    }
+}
+
+namespace
+{
+    constexpr auto hudHeight = 24;
+    constexpr auto hudBarWidth = 28;
+}
+
+// Health bars, icons and score rendered into one texture that is only rebuilt when something visible changes.
+// Values are compared after rounding to the pixels they cover, so slowly easing bars don't rebuild every frame
+class Hud
+{
+public:
+    Hud() = default;
+    Hud(const Hud&) = delete;
+    Hud& operator=(const Hud&) = delete;
+
+    ~Hud()
+    {
+        delete m_texture;
+    }
+
+    void Setup(tako::Font* font, ResourceCache& resources)
+    {
+        m_font = font;
+        m_hearth = resources.Bitmap("/Hearth.png");
+        m_turnip = resources.Bitmap("/TurnipUI.png");
+        m_rabbit = resources.Bitmap("/RabbitUI.png");
+        m_width = 0;
+    }
+
+    // The icons are reloaded in place by the cache, only the texture needs building again
+    void Invalidate()
+    {
+        m_width = 0;
+    }
+
+    void Draw(tako::PixelArtDrawer* drawer, tako::Vector2 cameraSize, float carrotHealth, float playerHunger, int score)
+    {
+        int width = cameraSize.x;
+        int carrotBar = hudBarWidth * carrotHealth / 100;
+        int hungerBar = hudBarWidth * playerHunger / 100;
+        if (width != m_width || carrotBar != m_carrotBar || hungerBar != m_hungerBar || score != m_score)
+        {
+            m_width = width;
+            m_carrotBar = carrotBar;
+            m_hungerBar = hungerBar;
+            m_score = score;
+            Rebuild(drawer);
+        }
+        drawer->DrawImage(0, cameraSize.y, m_width, hudHeight, m_texture);
+    }
+
+    int Rebuilds()
+    {
+        return m_rebuilds;
+    }
+
+private:
+    void Rebuild(tako::PixelArtDrawer* drawer)
+    {
+        tako::Bitmap bitmap(m_width, hudHeight);
+        FillBitmap(bitmap, 0, 0, m_width, hudHeight, {0, 0, 0, 0});
+        DrawBar(bitmap, 4, *m_hearth, m_carrotBar);
+        DrawBar(bitmap, 14, *m_turnip, m_hungerBar);
+
+        char digits[16];
+        auto end = std::to_chars(digits, digits + sizeof(digits), m_score).ptr;
+        auto text = m_font->RenderText({digits, size_t(end - digits)}, 1);
+        BlitBitmap(bitmap, m_width - 12, 3, 8, 8, *m_rabbit, 0, 0, m_rabbit->Width(), m_rabbit->Height());
+        BlitBitmap(bitmap, m_width - text.Width() - 16, 4, text);
+
+        if (m_texture)
+        {
+            delete m_texture;
+        }
+        m_texture = drawer->CreateTexture(bitmap);
+        m_rebuilds++;
+    }
+
+    void DrawBar(tako::Bitmap& bitmap, int y, const tako::Bitmap& icon, int fill)
+    {
+        BlitBitmap(bitmap, 4, y, 8, 8, icon, 0, 0, icon.Width(), icon.Height());
+        FillBitmap(bitmap, 14, y, 32, 8, {255, 255, 255, 255});
+        FillBitmap(bitmap, 15, y + 1, 30, 6, {0, 0, 0, 255});
+        FillBitmap(bitmap, 16, y + 2, fill, 4, {255, 255, 255, 255});
+    }
+
+    tako::Font* m_font = nullptr;
+    Resource<tako::Bitmap> m_hearth;
+    Resource<tako::Bitmap> m_turnip;
+    Resource<tako::Bitmap> m_rabbit;
+    tako::Texture* m_texture = nullptr;
+    int m_width = 0;
+    int m_carrotBar = -1;
+    int m_hungerBar = -1;
+    int m_score = -1;
+    int m_rebuilds = 0;
+};
@@ -0,0 +1,131 @@
+#pragma once
+#include "Tako.hpp"
+#include "Player.hpp"
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+// Totals over the input edges that made it to the screen. A frame is a draw, an edge showing up in the first draw
+// after it was sampled took one
+struct InputLatencyStats
+{
+    size_t edges = 0;
+    size_t dropped = 0;
+    size_t frames = 0;
+    int maxFrames = 0;
+    double milliseconds = 0;
+    double maxMilliseconds = 0;
+
+    double AverageFrames() const
+    {
+        return edges ? double(frames) / edges : 0;
+    }
+
+    double AverageMilliseconds() const
+    {
+        return edges ? milliseconds / edges : 0;
+    }
+};
+
+// Follows every press and release of the local player from the first time it is sampled to the first draw that
+// shows its effect. A step consumes every edge sampled before it and a published frame carries the last one consumed,
+// a late latched draw shows movement edges right away. Sampling runs with the update and every draw, latched or not,
+// and presenting with the draw
+class InputLatency
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // Buttons that show in a late latched draw, and the held ones whose release counts as an edge as well
+    static constexpr PlayerInput latchedButtons = InputButton::Left | InputButton::Right;
+    static constexpr PlayerInput heldButtons = InputButton::Left | InputButton::Right | InputButton::Jump;
+
+    InputLatency()
+    {
+        m_pending.reserve(maxPending);
+    }
+
+    void Sample(PlayerInput buttons, Clock::time_point now)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        PlayerInput edges = (buttons & ~m_last) | (m_last & ~buttons & heldButtons);
+        m_last = buttons;
+        if (!edges)
+        {
+            return;
+        }
+        if (m_pending.size() == maxPending)
+        {
+            m_pending.erase(m_pending.begin());
+            m_stats.dropped++;
+        }
+        m_pending.push_back({++m_sampled, edges, m_frame, now});
+    }
+
+    void Stepped()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stepped = m_sampled;
+    }
+
+    // Last edge a step consumed, what a frame published now shows
+    tako::U32 SteppedSerial() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_stepped;
+    }
+
+    void Present(tako::U32 steppedSerial, bool latched, Clock::time_point now)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_frame++;
+        auto shown = std::remove_if(m_pending.begin(), m_pending.end(), [&](const Edge& edge)
+        {
+            if (edge.serial > steppedSerial && !(latched && (edge.buttons & ~latchedButtons) == 0))
+            {
+                return false;
+            }
+            int frames = m_frame - edge.frame;
+            double milliseconds = std::chrono::duration<double, std::milli>(now - edge.sampled).count();
+            m_stats.edges++;
+            m_stats.frames += frames;
+            m_stats.maxFrames = std::max(m_stats.maxFrames, frames);
+            m_stats.milliseconds += milliseconds;
+            m_stats.maxMilliseconds = std::max(m_stats.maxMilliseconds, milliseconds);
+            return true;
+        });
+        m_pending.erase(shown, m_pending.end());
+    }
+
+    InputLatencyStats Stats() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_stats;
+    }
+
+    void ResetStats()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stats = {};
+    }
+
+private:
+    static constexpr size_t maxPending = 64;
+
+    struct Edge
+    {
+        tako::U32 serial;
+        PlayerInput buttons;
+        tako::U32 frame;
+        Clock::time_point sampled;
+    };
+
+    mutable std::mutex m_mutex;
+    std::vector<Edge> m_pending;
+    PlayerInput m_last = 0;
+    tako::U32 m_sampled = 0;
+    tako::U32 m_stepped = 0;
+    tako::U32 m_frame = 0;
+    InputLatencyStats m_stats;
+};
@@ -1,40 +1,357 @@
 #pragma once
 #include "Tako.hpp"
 #include <map>
+#include <memory_resource>
 #include <array>
 #include <vector>
 #include "Rect.hpp"
+#include "ResourceCache.hpp"
 #include <functional>
+#include <string_view>
+#include <cmath>
+#include <algorithm>
 
 namespace
 {
     constexpr auto tilesetTileCount = 15;
+    constexpr auto chunkSize = 32;
 }
 
+using LevelCallbacks = std::pmr::map<char, std::function<void(int,int)>>;
+
+struct LevelChunk
+{
+    bool loaded;
+    std::vector<tako::U8> tiles;
+    std::vector<std::pair<tako::U8, tako::U16>> packed;
+    // Solid tiles merged into as few rectangles as possible, kept whether the chunk is loaded or not.
+    // One bit per tile and row rejects queries that can't hit any of them
+    std::vector<Rect> solids;
+    std::array<tako::U32, chunkSize> solidRows;
+};
+static_assert(chunkSize <= 32, "solidRows holds a chunk row in one word");
+
 class Level
 {
 public:
-    Level(const char* file, tako::PixelArtDrawer* drawer, std::map<char, std::function<void(int,int)>>& callbackMap)
+    Level(const char* file, ResourceCache& resources, LevelCallbacks& callbackMap)
+    {
+        LoadTileset(resources);
+        if (auto packed = resources.Archive().Find(file))
+        {
+            Load(packed->data, callbackMap);
+            return;
+        }
+        auto buffer = ReadLevelFile(file);
+        Load({reinterpret_cast<const char*>(buffer.data()), buffer.size()}, callbackMap);
+    }
+
+    Level(std::string_view levelStr, LevelCallbacks& callbackMap)
+    {
+        Load(levelStr, callbackMap);
+    }
+
+    static std::vector<tako::U8> ReadLevelFile(const char* file)
+    {
+        size_t bufferSize = 1024 * 1024;
+        std::vector<tako::U8> buffer;
+        size_t bytesRead = 0;
+        while (true)
+        {
+            buffer.resize(bufferSize);
+            if (!tako::FileSystem::ReadFile(file, buffer.data(), bufferSize, bytesRead))
+            {
+                LOG_ERR("Could not read level {}", file);
+                bytesRead = 0;
+                break;
+            }
+            if (bytesRead < bufferSize)
+            {
+                break;
+            }
+            bufferSize *= 4;
+        }
+        buffer.resize(bytesRead);
+        return buffer;
+    }
+
+    // Shared with every other level alive, reloads of the tileset update the sprites in place
+    void LoadTileset(ResourceCache& resources)
     {
-        auto bitmap = tako::Bitmap::FromFile("/Tileset.png");
-        auto tileset = drawer->CreateTexture(bitmap);
-        int tilesPerTilesetRow = bitmap.Width() / 16;
+        auto tileset = resources.Texture("/Tileset.png");
+        int tilesPerTilesetRow = tileset.Width() / 16;
         for (int i = 0; i < tilesetTileCount; i++)
         {
             int y = i / tilesPerTilesetRow;
             int x = i - y * tilesPerTilesetRow;
-            m_tileSprites[i] = drawer->CreateSprite(tileset, x * 16, y * 16, 16, 16);
+            m_tiles[i] = resources.Sprite("/Tileset.png", x * 16, y * 16, 16, 16);
+            m_tileSprites[i] = m_tiles[i].Get();
         }
+    }
 
-        constexpr size_t bufferSize = 1024 * 1024;
-        std::array <tako::U8, bufferSize> buffer;
-        size_t bytesRead = 0;
-        if (!tako::FileSystem::ReadFile(file, buffer.data(), bufferSize, bytesRead))
+    size_t TileMemory()
+    {
+        size_t memory = m_chunks.capacity() * sizeof(LevelChunk);
+        for (auto& chunk : m_chunks)
+        {
+            memory += chunk.tiles.capacity() * sizeof(tako::U8) + chunk.packed.capacity() * sizeof(chunk.packed[0]);
+            memory += chunk.solids.capacity() * sizeof(Rect);
+        }
+        return memory;
+    }
+
+    template<typename Drawer>
+    void Draw(Drawer* drawer, Rect view)
+    {
+        int minX = std::max(0, (int) std::floor(view.Left() / 16));
+        int maxX = std::min(m_width - 1, (int) std::floor(view.Right() / 16));
+        int minY = std::max(0, (int) std::floor(view.Bottom() / 16) - 1);
+        int maxY = std::min(m_height, (int) std::floor(view.Top() / 16));
+        for (int y = maxY; y >= minY; y--)
+        {
+            for (int x = minX; x <= maxX; x++)
+            {
+                int tile = GetTile(x, y);
+                if (tile == 0)
+                {
+                    continue;
+                }
+
+                drawer->DrawSprite(x * 16, y * 16 + 16, 16, 16, m_tileSprites[tile - 1]);
+            }
+        }
+
+    }
+
+    // Tests against the merged solids of the chunks the rect touches, a body resting on a platform keeps hitting
+    // the same rectangle instead of whichever tile comes first
+    std::optional<Rect> Overlap(Rect rect)
+    {
+        int left = std::max(0, (int) std::floor(rect.Left() / 16));
+        int right = std::min(m_chunksX * chunkSize - 1, (int) std::floor(rect.Right() / 16));
+        int bottom = std::max(0, (int) std::floor(rect.Bottom() / 16));
+        int top = std::min(m_chunksY * chunkSize - 1, (int) std::floor(rect.Top() / 16));
+        if (left > right || bottom > top)
+        {
+            return std::nullopt;
+        }
+        for (int cy = bottom / chunkSize; cy <= top / chunkSize; cy++)
+        {
+            for (int cx = left / chunkSize; cx <= right / chunkSize; cx++)
+            {
+                auto& chunk = m_chunks[cy * m_chunksX + cx];
+                int x0 = std::max(left - cx * chunkSize, 0);
+                int x1 = std::min(right - cx * chunkSize, chunkSize - 1);
+                tako::U32 columns = (~0u >> (chunkSize - 1 - x1)) & (~0u << x0);
+                bool any = false;
+                for (int y = std::max(bottom - cy * chunkSize, 0); y <= std::min(top - cy * chunkSize, chunkSize - 1) && !any; y++)
+                {
+                    any = chunk.solidRows[y] & columns;
+                }
+                if (!any)
+                {
+                    continue;
+                }
+                for (auto& solid : chunk.solids)
+                {
+                    if (Rect::Overlap(solid, rect))
+                    {
+                        return solid;
+                    }
+                }
+            }
+        }
+
+        return std::nullopt;
+    }
+
+    int Width()
+    {
+        return m_width;
+    }
+
+    int Height()
+    {
+        return m_height;
+    }
+
+    int GetTile(int x, int y)
+    {
+        if (x < 0 || x >= m_width || y < 0 || y > m_height)
+        {
+            return 0;
+        }
+        auto& chunk = m_chunks[(y / chunkSize) * m_chunksX + x / chunkSize];
+        int local = (y % chunkSize) * chunkSize + x % chunkSize;
+        if (chunk.loaded)
+        {
+            return chunk.tiles[local];
+        }
+        for (auto [tile, count] : chunk.packed)
         {
-            LOG_ERR("Could not read level {}", file);
+            if (local < count)
+            {
+                return tile;
+            }
+            local -= count;
+        }
+        return 0;
+    }
+
+    bool IsSolid(int x, int y)
+    {
+        return GetTile(x, y) != 0;
+    }
+
+    void SetTile(int x, int y, int tile)
+    {
+        if (x < 0 || x >= m_width || y < 0 || y > m_height)
+        {
+            return;
+        }
+        int cx = x / chunkSize;
+        int cy = y / chunkSize;
+        bool wasLoaded = IsChunkLoaded(cx, cy);
+        LoadChunk(cx, cy);
+        m_chunks[cy * m_chunksX + cx].tiles[(y % chunkSize) * chunkSize + x % chunkSize] = tile;
+        MergeSolids(m_chunks[cy * m_chunksX + cx]);
+        if (!wasLoaded)
+        {
+            UnloadChunk(cx, cy);
         }
+    }
+
+    int ChunksX()
+    {
+        return m_chunksX;
+    }
+
+    int ChunksY()
+    {
+        return m_chunksY;
+    }
+
+    bool IsChunkLoaded(int cx, int cy)
+    {
+        return m_chunks[cy * m_chunksX + cx].loaded;
+    }
 
-        auto levelStr = reinterpret_cast<const char *>(buffer.data());
+    void LoadChunk(int cx, int cy)
+    {
+        auto& chunk = m_chunks[cy * m_chunksX + cx];
+        if (chunk.loaded)
+        {
+            return;
+        }
+        chunk.tiles.clear();
+        chunk.tiles.reserve(chunkSize * chunkSize);
+        for (auto [tile, count] : chunk.packed)
+        {
+            chunk.tiles.insert(chunk.tiles.end(), count, tile);
+        }
+        chunk.packed.clear();
+        chunk.packed.shrink_to_fit();
+        chunk.loaded = true;
+    }
+
+    // Unloaded chunks keep their tiles run-length encoded, lookups still work but are slower
+    void UnloadChunk(int cx, int cy)
+    {
+        auto& chunk = m_chunks[cy * m_chunksX + cx];
+        if (!chunk.loaded)
+        {
+            return;
+        }
+        chunk.packed.clear();
+        for (auto tile : chunk.tiles)
+        {
+            if (chunk.packed.empty() || chunk.packed.back().first != tile)
+            {
+                chunk.packed.emplace_back(tile, 0);
+            }
+            chunk.packed.back().second++;
+        }
+        chunk.packed.shrink_to_fit();
+        chunk.tiles.clear();
+        chunk.tiles.shrink_to_fit();
+        chunk.loaded = false;
+    }
+
+    Rect MapBounds()
+    {
+        float width = m_width * 16;
+        float height = m_height * 16;
+        return
+        {
+            width / 2,
+            height / 2,
+            width,
+            height
+        };
+    }
+private:
+    // Greedy merge of a loaded chunk: every uncovered solid tile starts a run along its row,
+    // which then grows upwards for as long as the full width of the next row is solid and uncovered
+    void MergeSolids(LevelChunk& chunk)
+    {
+        int index = &chunk - m_chunks.data();
+        int originX = (index % m_chunksX) * chunkSize;
+        int originY = (index / m_chunksX) * chunkSize;
+        std::array<bool, chunkSize * chunkSize> covered = {};
+        auto free = [&](int x, int y)
+        {
+            int local = y * chunkSize + x;
+            return chunk.tiles[local] != 0 && !covered[local];
+        };
+        chunk.solids.clear();
+        for (int y = 0; y < chunkSize; y++)
+        {
+            chunk.solidRows[y] = 0;
+            for (int x = 0; x < chunkSize; x++)
+            {
+                chunk.solidRows[y] |= tako::U32(chunk.tiles[y * chunkSize + x] != 0) << x;
+            }
+        }
+        for (int y = 0; y < chunkSize; y++)
+        {
+            for (int x = 0; x < chunkSize; x++)
+            {
+                if (!free(x, y))
+                {
+                    continue;
+                }
+                int w = 1;
+                while (x + w < chunkSize && free(x + w, y))
+                {
+                    w++;
+                }
+                int h = 1;
+                while (y + h < chunkSize)
+                {
+                    bool rowFree = true;
+                    for (int i = x; i < x + w && rowFree; i++)
+                    {
+                        rowFree = free(i, y + h);
+                    }
+                    if (!rowFree)
+                    {
+                        break;
+                    }
+                    h++;
+                }
+                for (int j = y; j < y + h; j++)
+                {
+                    std::fill_n(covered.begin() + j * chunkSize + x, w, true);
+                }
+                chunk.solids.push_back({(originX + x + w / 2.0f) * 16, (originY + y + h / 2.0f) * 16, w * 16.0f, h * 16.0f});
+            }
+        }
+        chunk.solids.shrink_to_fit();
+    }
+
+    void Load(std::string_view levelStr, LevelCallbacks& callbackMap)
+    {
+        size_t bytesRead = levelStr.size();
         std::vector<char> tileChars;
         tileChars.reserve(bytesRead);
         {
@@ -57,6 +374,9 @@ public:
             m_width = maxX;
             m_height = maxY;
         }
+        m_chunksX = (m_width + chunkSize - 1) / chunkSize;
+        m_chunksY = (m_height + chunkSize) / chunkSize;
+        m_chunks.assign(m_chunksX * m_chunksY, {true, std::vector<tako::U8>(chunkSize * chunkSize, 0), {}, {}, {}});
 
         for (int i = 0; i < tileChars.size(); i++)
         {
@@ -103,91 +423,29 @@ public:
                     tile = 14;
                     break;
             }
+            int y = m_height - i / m_width;
+            int x = i % m_width;
             if (callbackMap.find(tileChars[i]) != callbackMap.end())
             {
-                int y = m_height - i / m_width;
-                int x = i % m_width;
                 callbackMap[tileChars[i]](x, y);
             }
 
-            m_tiles.push_back(tile);
-        }
-    }
-
-    void Draw(tako::PixelArtDrawer* drawer)
-    {
-        for (int y = m_height; y >= 0; y--)
-        {
-            for (int x = 0; x < m_width; x++)
+            if (y >= 0)
             {
-                int i = (m_height - y) * m_width + x;
-                int tile = m_tiles[i];
-                if (tile == 0)
-                {
-                    continue;
-                }
-
-                drawer->DrawSprite(x * 16, y * 16 + 16, 16, 16, m_tileSprites[tile - 1]);
+                m_chunks[(y / chunkSize) * m_chunksX + x / chunkSize].tiles[(y % chunkSize) * chunkSize + x % chunkSize] = tile;
             }
         }
-
-    }
-
-    std::optional<Rect> Overlap(Rect rect)
-    {
-        /*
-            TL TM TR
-            ML MM MR
-            BL BM BR
-        */
-        int tileX = ((int) rect.x) / 16;
-        int tileY = ((int) rect.y) / 16;
-
-        Rect r;
-        for (int y = -1; y <= 1; y++)
+        for (auto& chunk : m_chunks)
         {
-            for (int x = -1; x <= 1; x++)
-            {
-                int tX = tileX + x;
-                int tY = tileY + y;
-
-                if (tX < 0 || tX > m_width || tY < 0 || tY > m_height)
-                {
-                    continue;
-                }
-                int i = (m_height - tY) * m_width + tX;
-                int tile = m_tiles[i];
-                if (tile == 0)
-                {
-                    continue;
-                }
-
-                r = { tX * 16.0f + 8, tY * 16.0f + 8, 16, 16};
-                if (Rect::Overlap(r, rect))
-                {
-                    return r;
-                }
-            }
+            MergeSolids(chunk);
         }
-
-        return std::nullopt;
     }
 
-    Rect MapBounds()
-    {
-        float width = m_width * 16;
-        float height = m_height * 16;
-        return
-        {
-            width / 2,
-            height / 2,
-            width,
-            height
-        };
-    }
-private:
-    std::array<tako::Sprite*, tilesetTileCount> m_tileSprites;
-    std::vector<int> m_tiles;
+    std::array<Resource<tako::Sprite>, tilesetTileCount> m_tiles;
+    std::array<tako::Sprite*, tilesetTileCount> m_tileSprites = {};
+    std::vector<LevelChunk> m_chunks;
+    int m_chunksX;
+    int m_chunksY;
     int m_width;
     int m_height;
 };
\ No newline at end of file
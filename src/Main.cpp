@@ -2,6 +2,8 @@
 #include "Game.hpp"
 
 static Game game;
+// Input tako polled for the frame, draws read its key state again for the late latch
+static tako::Input* frameInput = nullptr;
 
 void tako::Setup(tako::PixelArtDrawer* drawer)
 {
@@ -10,10 +12,11 @@ void tako::Setup(tako::PixelArtDrawer* drawer)
 
 void tako::Update(tako::Input* input, float dt)
 {
+    frameInput = input;
     game.Update(input, dt);
 }
 
 void tako::Draw(tako::PixelArtDrawer* drawer)
 {
-    game.Draw(drawer);
+    game.Draw(drawer, frameInput ? Game::ReadInput(frameInput) : 0);
 }
\ No newline at end of file
@@ -0,0 +1,319 @@
+#pragma once
+#include "Tako.hpp"
+#include "Level.hpp"
+#include <vector>
+#include <cstdint>
+#include <deque>
+#include <cmath>
+#include <algorithm>
+
+namespace
+{
+    constexpr auto hopSpeedX = 30.0f;
+    constexpr auto hopGravity = 20.0f;
+    constexpr auto hopMaxSpeedY = 60.0f;
+    constexpr auto hopMinSpeedY = 5.0f;
+    constexpr auto hopMaxTilesX = 4;
+    constexpr auto hopMaxTilesUp = 2;
+    constexpr auto hopMaxTilesDown = 4;
+    constexpr auto hopArcSamples = 8;
+    constexpr auto hopColumns = hopMaxTilesX * 2 + 1;
+    constexpr auto hopCount = hopColumns * (hopMaxTilesUp + hopMaxTilesDown + 1);
+    static_assert(hopCount <= 64, "Hops must fit in the node hop mask");
+}
+
+struct NavigationStep
+{
+    int next;
+    tako::Vector2 impulse;
+};
+
+// Flow field over the standing tiles of a level, pointing every tile to the hop that gets a rabbit closer to the target
+class NavigationField
+{
+public:
+    void Build(Level* level, int targetX, int targetY)
+    {
+        m_level = level;
+        m_width = level->Width();
+        m_height = level->Height() + 1;
+        m_target = Index(targetX, targetY);
+        m_nodeOfTile.assign(m_width * m_height, -1);
+        m_nodes.clear();
+        for (int y = 0; y < m_height; y++)
+        {
+            for (int x = 0; x < m_width; x++)
+            {
+                UpdateNode(x, y);
+            }
+        }
+        for (auto& node : m_nodes)
+        {
+            BuildHops(node);
+        }
+        Refresh();
+    }
+
+    // Only the hops whose arc could pass the changed tile are recomputed, call Refresh once all changes are in
+    void TileChanged(int x, int y)
+    {
+        if (!m_level)
+        {
+            return;
+        }
+        for (int sy = y; sy <= y + 1; sy++)
+        {
+            if (InBounds(x, sy))
+            {
+                UpdateNode(x, sy);
+            }
+        }
+        for (int ey = y - hopMaxTilesUp - 2; ey <= y + hopMaxTilesDown + 2; ey++)
+        {
+            for (int ex = x - hopMaxTilesX; ex <= x + hopMaxTilesX; ex++)
+            {
+                if (InBounds(ex, ey) && m_nodeOfTile[Index(ex, ey)] >= 0)
+                {
+                    BuildHops(m_nodes[m_nodeOfTile[Index(ex, ey)]]);
+                }
+            }
+        }
+    }
+
+    void Refresh()
+    {
+        Compact();
+        int nodeCount = m_nodes.size();
+        std::vector<int> incomingStart(nodeCount + 1, 0);
+        for (auto& node : m_nodes)
+        {
+            node.step = {-1, {0, 0}};
+            ForEachHop(node, [&](int to, int hop)
+            {
+                incomingStart[to + 1]++;
+            });
+        }
+        for (int i = 0; i < nodeCount; i++)
+        {
+            incomingStart[i + 1] += incomingStart[i];
+        }
+        std::vector<int> incoming(incomingStart[nodeCount]);
+        std::vector<int> fill(incomingStart.begin(), incomingStart.end() - 1);
+        for (int i = 0; i < nodeCount; i++)
+        {
+            ForEachHop(m_nodes[i], [&](int to, int hop)
+            {
+                incoming[fill[to]++] = i;
+            });
+        }
+
+        if (m_target < 0 || m_target >= m_nodeOfTile.size() || m_nodeOfTile[m_target] < 0)
+        {
+            return;
+        }
+        int target = m_nodeOfTile[m_target];
+        std::vector<bool> visited(nodeCount, false);
+        std::deque<int> open;
+        visited[target] = true;
+        open.push_back(target);
+        while (!open.empty())
+        {
+            int node = open.front();
+            open.pop_front();
+            for (int i = incomingStart[node]; i < incomingStart[node + 1]; i++)
+            {
+                int from = incoming[i];
+                if (visited[from])
+                {
+                    continue;
+                }
+                visited[from] = true;
+                ForEachHop(m_nodes[from], [&](int to, int hop)
+                {
+                    if (to == node && m_nodes[from].step.next < 0)
+                    {
+                        m_nodes[from].step = {m_nodes[node].tile, HopImpulse(hop)};
+                    }
+                });
+                open.push_back(from);
+            }
+        }
+    }
+
+    const NavigationStep* Lookup(tako::Vector2 feet)
+    {
+        int x = (int) std::floor(feet.x / 16);
+        int y = (int) std::floor((feet.y + 1) / 16);
+        if (!InBounds(x, y))
+        {
+            return nullptr;
+        }
+        int node = m_nodeOfTile[Index(x, y)];
+        if (node < 0 || m_nodes[node].step.next < 0)
+        {
+            return nullptr;
+        }
+        return &m_nodes[node].step;
+    }
+
+private:
+    // Hops are stored as one bit per tile offset, the target node is looked up through the tile grid when needed
+    struct Node
+    {
+        int tile;
+        std::uint64_t hops;
+        NavigationStep step;
+    };
+
+    int Index(int x, int y)
+    {
+        return y * m_width + x;
+    }
+
+    bool InBounds(int x, int y)
+    {
+        return x >= 0 && x < m_width && y >= 0 && y < m_height;
+    }
+
+    bool IsStandable(int x, int y)
+    {
+        return !m_level->IsSolid(x, y) && m_level->IsSolid(x, y - 1);
+    }
+
+    static int HopDX(int hop)
+    {
+        return hop % hopColumns - hopMaxTilesX;
+    }
+
+    static int HopDY(int hop)
+    {
+        return hop / hopColumns - hopMaxTilesDown;
+    }
+
+    static float HopDurationAtSpeed(int hop)
+    {
+        return std::abs(HopDX(hop)) * 16 / hopSpeedX;
+    }
+
+    // Vertical speed that lands on the target while moving at the hop speed, may point down for drops
+    static float HopSpeedY(int hop)
+    {
+        float duration = HopDurationAtSpeed(hop);
+        return (HopDY(hop) * 16 + hopGravity * duration * duration / 2) / duration;
+    }
+
+    // Drops that would have to start downwards take off at the lowest vertical speed instead and fall for longer
+    static float HopDuration(int hop)
+    {
+        if (HopSpeedY(hop) >= hopMinSpeedY)
+        {
+            return HopDurationAtSpeed(hop);
+        }
+        float drop = -HopDY(hop) * 16.0f;
+        return (hopMinSpeedY + std::sqrt(hopMinSpeedY * hopMinSpeedY + 2 * hopGravity * drop)) / hopGravity;
+    }
+
+    // Slowed down horizontally when the hop falls for longer, so it still comes down on the target tile
+    static tako::Vector2 HopImpulse(int hop)
+    {
+        return {HopDX(hop) * 16 / HopDuration(hop), std::max(hopMinSpeedY, HopSpeedY(hop))};
+    }
+
+    template<typename Visit>
+    void ForEachHop(const Node& node, Visit visit)
+    {
+        for (int hop = 0; hop < hopCount; hop++)
+        {
+            if (!(node.hops >> hop & 1))
+            {
+                continue;
+            }
+            int to = m_nodeOfTile[node.tile + HopDY(hop) * m_width + HopDX(hop)];
+            if (to >= 0)
+            {
+                visit(to, hop);
+            }
+        }
+    }
+
+    // Nodes that stop being standable are left as empty husks until the next Refresh compacts them
+    void UpdateNode(int x, int y)
+    {
+        int tile = Index(x, y);
+        bool standable = IsStandable(x, y);
+        int node = m_nodeOfTile[tile];
+        if (standable && node < 0)
+        {
+            m_nodeOfTile[tile] = m_nodes.size();
+            m_nodes.push_back({tile, 0, {-1, {0, 0}}});
+        }
+        else if (!standable && node >= 0)
+        {
+            m_nodes[node] = {-1, 0, {-1, {0, 0}}};
+            m_nodeOfTile[tile] = -1;
+        }
+    }
+
+    void Compact()
+    {
+        auto end = std::remove_if(m_nodes.begin(), m_nodes.end(), [](const Node& node)
+        {
+            return node.tile < 0;
+        });
+        if (end == m_nodes.end())
+        {
+            return;
+        }
+        m_nodes.erase(end, m_nodes.end());
+        for (int i = 0; i < (int) m_nodes.size(); i++)
+        {
+            m_nodeOfTile[m_nodes[i].tile] = i;
+        }
+    }
+
+    bool ArcIsClear(tako::Vector2 start, tako::Vector2 impulse, float duration)
+    {
+        for (int i = 1; i <= hopArcSamples; i++)
+        {
+            float t = duration * i / hopArcSamples;
+            tako::Vector2 p(start.x + impulse.x * t, start.y + 6 + impulse.y * t - hopGravity * t * t / 2);
+            if (m_level->IsSolid((int) std::floor(p.x / 16), (int) std::floor(p.y / 16)))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void BuildHops(Node& node)
+    {
+        node.hops = 0;
+        if (node.tile < 0)
+        {
+            return;
+        }
+        int x = node.tile % m_width;
+        int y = node.tile / m_width;
+        tako::Vector2 start(x * 16 + 8, y * 16);
+        for (int hop = 0; hop < hopCount; hop++)
+        {
+            int tx = x + HopDX(hop);
+            int ty = y + HopDY(hop);
+            if (HopDX(hop) == 0 || !InBounds(tx, ty) || m_nodeOfTile[Index(tx, ty)] < 0 || HopSpeedY(hop) > hopMaxSpeedY)
+            {
+                continue;
+            }
+            if (ArcIsClear(start, HopImpulse(hop), HopDuration(hop)))
+            {
+                node.hops |= std::uint64_t(1) << hop;
+            }
+        }
+    }
+
+    Level* m_level = nullptr;
+    int m_width = 0;
+    int m_height = 0;
+    int m_target = -1;
+    std::vector<int> m_nodeOfTile;
+    std::vector<Node> m_nodes;
+};
@@ -3,12 +3,72 @@
 #include "Position.hpp"
 #include "World.hpp"
 #include "Level.hpp"
+#include "Simd.hpp"
 #include <algorithm>
+#include <type_traits>
+
+namespace BodyTag
+{
+    enum : tako::U8
+    {
+        Player = 1 << 0,
+        Enemy = 1 << 1,
+        Carrot = 1 << 2,
+        Turnip = 1 << 3
+    };
+}
 
 struct RigidBody
 {
     tako::Vector2 size;
     tako::Entity entity;
+    tako::U8 tags;
+    tako::U8 collidesWith;
+};
+
+struct BodyBatch
+{
+    std::vector<float> x, y, w, h;
+    std::vector<RigidBody*> bodies;
+    std::vector<tako::U8> hits;
+
+    void Clear()
+    {
+        x.clear();
+        y.clear();
+        w.clear();
+        h.clear();
+        bodies.clear();
+    }
+
+    void Reserve(size_t count)
+    {
+        x.reserve(count);
+        y.reserve(count);
+        w.reserve(count);
+        h.reserve(count);
+        bodies.reserve(count);
+        hits.reserve(count);
+    }
+};
+
+// Scratch arrays of IntegrateBallistic, the caller keeps one set per integrated component type
+template<typename T>
+struct BallisticBatch
+{
+    std::vector<Position*> positions;
+    std::vector<T*> bodies;
+    std::vector<float> x, y, vx, vy, tx, ty;
+
+    void Reserve(size_t count)
+    {
+        positions.reserve(count);
+        bodies.reserve(count);
+        for (auto array : {&x, &y, &vx, &vy, &tx, &ty})
+        {
+            array->reserve(count);
+        }
+    }
 };
 
 namespace Physics
@@ -19,8 +79,33 @@ namespace Physics
         return level->Overlap(n).has_value();
     }
 
-    void Move(tako::World& world, Level* level, Position& pos, RigidBody& rigid, tako::Vector2 movement, std::function<void()> levelCallback = {}, std::function<void(RigidBody&, tako::Vector2&)> rigidCallback = {})
+    // Bodies with any of the tags, except is left out so a mover doesn't collide with itself
+    void Gather(tako::World& world, tako::U8 tags, BodyBatch& batch, const RigidBody* except = nullptr)
     {
+        batch.Clear();
+        world.IterateComps<Position, RigidBody>([&](Position& otherPos, RigidBody& otherRigid)
+        {
+            if (!(tags & otherRigid.tags) || &otherRigid == except)
+            {
+                return;
+            }
+            batch.x.push_back(otherPos.x);
+            batch.y.push_back(otherPos.y);
+            batch.w.push_back(otherRigid.size.x);
+            batch.h.push_back(otherRigid.size.y);
+            batch.bodies.push_back(&otherRigid);
+        });
+        batch.hits.resize(batch.bodies.size());
+    }
+
+    // Targets is only asked for the bodies once the mover actually needs them
+    template<typename Targets, typename LevelCallback, typename RigidCallback>
+    void MoveThrough(Level* level, Position& pos, RigidBody& rigid, tako::Vector2 movement, Targets&& targets, LevelCallback& levelCallback, RigidCallback& rigidCallback)
+    {
+        constexpr bool hasLevelCallback = !std::is_same_v<LevelCallback, std::nullptr_t>;
+        constexpr bool hasRigidCallback = !std::is_same_v<RigidCallback, std::nullptr_t>;
+        bool levelHit = false;
+        BodyBatch* gathered = nullptr;
         Rect n;
         int iterations = 0;
         while ((tako::mathf::abs(movement.x) > 0.0000001f || tako::mathf::abs(movement.y) > 0.0000001f) && iterations < 10)
@@ -32,29 +117,36 @@ namespace Physics
                 mov.normalize();
             }
             n = {pos.AsVec() + mov, rigid.size};
-            if (rigidCallback)
+            if constexpr (hasRigidCallback)
             {
-                world.IterateComps<Position, RigidBody>([&](Position& otherPos, RigidBody& otherRigid)
+                if (rigid.collidesWith)
                 {
-                    if (&rigid == &otherRigid)
+                    if (!gathered)
                     {
-                        return;
+                        gathered = &targets();
                     }
-                    Rect otherN(otherPos.AsVec(), otherRigid.size);
-                    if (Rect::Overlap(n, otherN))
+                    auto& batch = *gathered;
+                    Simd::Overlap(n, batch.x.data(), batch.y.data(), batch.w.data(), batch.h.data(), batch.bodies.size(), batch.hits.data());
+                    for (int i = 0; i < batch.bodies.size(); i++)
                     {
-                        rigidCallback(otherRigid, movement);
+                        if (batch.hits[i] && batch.bodies[i] != &rigid)
+                        {
+                            rigidCallback(*batch.bodies[i], movement);
+                        }
                     }
-                });
+                }
             }
 
             auto overlap = level->Overlap(n);
             if (overlap)
             {
-                if (levelCallback)
+                if constexpr (hasLevelCallback)
                 {
-                    levelCallback();
-                    levelCallback = {};
+                    if (!levelHit)
+                    {
+                        levelCallback();
+                        levelHit = true;
+                    }
                 }
                 auto other = overlap.value();
                 Rect ny(pos.AsVec() + tako::Vector2(0, mov.y), rigid.size);
@@ -93,4 +185,74 @@ namespace Physics
             movement -= mov;
         }
     }
+
+    // Callbacks are taken as templates so the closures don't need a heap allocated std::function on every move.
+    // The bodies the mover collides with are gathered into scratch, which the caller keeps between moves
+    template<typename LevelCallback = std::nullptr_t, typename RigidCallback = std::nullptr_t>
+    void Move(tako::World& world, BodyBatch& scratch, Level* level, Position& pos, RigidBody& rigid, tako::Vector2 movement, LevelCallback levelCallback = {}, RigidCallback rigidCallback = {})
+    {
+        MoveThrough(level, pos, rigid, movement, [&]() -> BodyBatch&
+        {
+            Gather(world, rigid.collidesWith, scratch, &rigid);
+            return scratch;
+        }, levelCallback, rigidCallback);
+    }
+
+    // For passes whose movers all collide with a set of bodies that doesn't move during the pass, gathered once
+    // up front instead of once per mover
+    template<typename LevelCallback = std::nullptr_t, typename RigidCallback = std::nullptr_t>
+    void MoveAgainst(BodyBatch& targets, Level* level, Position& pos, RigidBody& rigid, tako::Vector2 movement, LevelCallback levelCallback = {}, RigidCallback rigidCallback = {})
+    {
+        MoveThrough(level, pos, rigid, movement, [&]() -> BodyBatch&
+        {
+            return targets;
+        }, levelCallback, rigidCallback);
+    }
+
+    // Bodies flying without a RigidBody (particles, corpses): integrated in one batch, bouncing off the level
+    template<typename T>
+    void IntegrateBallistic(tako::World& world, BallisticBatch<T>& batch, Level* level, float dt, float gravity, tako::Vector2 size)
+    {
+        auto& positions = batch.positions;
+        auto& bodies = batch.bodies;
+        auto& x = batch.x;
+        auto& y = batch.y;
+        auto& vx = batch.vx;
+        auto& vy = batch.vy;
+        auto& tx = batch.tx;
+        auto& ty = batch.ty;
+        positions.clear();
+        bodies.clear();
+        x.clear();
+        y.clear();
+        vx.clear();
+        vy.clear();
+        world.template IterateComps<Position, T>([&](Position& pos, T& body)
+        {
+            positions.push_back(&pos);
+            bodies.push_back(&body);
+            x.push_back(pos.x);
+            y.push_back(pos.y);
+            vx.push_back(body.speed.x);
+            vy.push_back(body.speed.y);
+        });
+        tx.resize(x.size());
+        ty.resize(x.size());
+        Simd::Integrate(x.data(), y.data(), vx.data(), vy.data(), tx.data(), ty.data(), x.size(), dt, gravity);
+        for (int i = 0; i < bodies.size(); i++)
+        {
+            auto& speed = bodies[i]->speed;
+            speed.y = vy[i];
+            Rect tRect({tx[i], ty[i]}, size);
+            if (level->Overlap(tRect))
+            {
+                speed /= -4;
+            }
+            else
+            {
+                positions[i]->x = tx[i];
+                positions[i]->y = ty[i];
+            }
+        }
+    }
 }
\ No newline at end of file
@@ -3,14 +3,29 @@
 #include "World.hpp"
 #include <optional>
 
+namespace InputButton
+{
+    enum : tako::U8
+    {
+        Left = 1,
+        Right = 2,
+        Jump = 4,
+        Throw = 8,
+        Eat = 16,
+        OneShot = Throw | Eat
+    };
+}
+
+// Buttons one player holds during a simulation step, Throw and Eat are only set on the step they got pressed
+using PlayerInput = tako::U8;
+
 struct Player
 {
+    int slot;
     tako::Vector2 speed;
     float hunger;
     float displayedHunger;
     float walkingPart;
-    float stepPart;
-    bool stepIndex;
     float lookDirection;
     float airTime;
     std::optional<tako::Entity> turnip;
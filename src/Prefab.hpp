@@ -0,0 +1,55 @@
+#pragma once
+#include "Tako.hpp"
+#include <tuple>
+
+// A complete set of component values for one kind of entity. Instantiating copies all of them into the new entity
+// at once, the setup only writes what differs per instance and gets the created components handed in
+template<typename... Components>
+class Prefab
+{
+public:
+    Prefab(Components... components) : m_components(components...)
+    {
+    }
+
+    template<typename Setup>
+    tako::Entity Instantiate(tako::World& world, Setup setup) const
+    {
+        auto entity = world.Create<Components...>();
+        std::tuple<Components&...> created(world.GetComponent<Components>(entity)...);
+        created = m_components;
+        std::apply([&](Components&... components)
+        {
+            setup(entity, components...);
+        }, created);
+        return entity;
+    }
+
+    tako::Entity Instantiate(tako::World& world) const
+    {
+        return Instantiate(world, [](tako::Entity entity, Components&... components) {});
+    }
+
+    // Bursts of the same prefab, the setup runs once per entity with its index in the burst
+    template<typename Setup>
+    void CreateMany(tako::World& world, int count, Setup setup) const
+    {
+        for (int i = 0; i < count; i++)
+        {
+            Instantiate(world, [&](tako::Entity entity, Components&... components)
+            {
+                setup(i, entity, components...);
+            });
+        }
+    }
+
+    // Lets a snapshot restore the entities of this prefab
+    template<typename Snapshot>
+    void AddShape(Snapshot& snapshot) const
+    {
+        snapshot.template AddShape<Components...>();
+    }
+
+private:
+    std::tuple<Components...> m_components;
+};
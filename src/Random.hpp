@@ -0,0 +1,32 @@
+#pragma once
+#include "Tako.hpp"
+
+// Deterministic xorshift generator, kept as part of the simulation state so replayed frames draw the same numbers
+struct Random
+{
+    tako::U32 state = 1;
+
+    void Seed(tako::U32 seed)
+    {
+        state = seed ? seed : 1;
+    }
+
+    tako::U32 Next()
+    {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+
+    int Int(int max)
+    {
+        return Next() % max;
+    }
+
+    // Uniform in [0, 1)
+    float Value()
+    {
+        return (Next() >> 8) * (1.0f / 16777216);
+    }
+};
@@ -0,0 +1,106 @@
+#pragma once
+#include "Tako.hpp"
+#include <array>
+#include <vector>
+#include <mutex>
+
+enum class RenderLayer : tako::U8
+{
+    Tiles,
+    Rectangles,
+    Background,
+    Foreground
+};
+
+// One draw call worth of data, the sprite is null for plain rectangles
+struct RenderItem
+{
+    tako::Vector2 position;
+    tako::Vector2 size;
+    tako::Sprite* sprite;
+    tako::Color color;
+    RenderLayer layer;
+};
+
+// Two copies of a frame, one written by the simulation and one read by the renderer.
+// Publish swaps them once the written one is complete, the reader never sees a frame that is still being built
+template<typename Frame>
+class DoubleBuffered
+{
+public:
+    Frame& Back()
+    {
+        return m_frames[m_back];
+    }
+
+    void Publish()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_back ^= 1;
+    }
+
+    // Holds the published frame for the duration of the reader, a Publish meanwhile waits for it to finish
+    template<typename Reader>
+    void Read(Reader reader)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        const Frame& front = m_frames[m_back ^ 1];
+        reader(front);
+    }
+
+private:
+    std::array<Frame, 2> m_frames;
+    int m_back = 0;
+    std::mutex m_mutex;
+};
+
+// Stands in for a drawer and records the sprites drawn through it, so code that draws can fill a render list instead
+class RenderListWriter
+{
+public:
+    RenderListWriter(std::vector<RenderItem>& items, RenderLayer layer) : m_items(items), m_layer(layer)
+    {
+    }
+
+    void DrawSprite(float x, float y, float w, float h, tako::Sprite* sprite)
+    {
+        m_items.push_back({{x + w / 2, y - h / 2}, {w, h}, sprite, {}, m_layer});
+    }
+
+private:
+    std::vector<RenderItem>& m_items;
+    RenderLayer m_layer;
+};
+
+template<typename Drawer>
+void SubmitRenderItem(Drawer* drawer, const RenderItem& item)
+{
+    if (item.sprite)
+    {
+        drawer->DrawSprite(item.position.x - item.size.x / 2, item.position.y + item.size.y / 2, item.size.x, item.size.y, item.sprite);
+    }
+    else
+    {
+        drawer->DrawRectangle(item.position.x - item.size.x / 2, item.position.y + item.size.y / 2, item.size.x, item.size.y, item.color);
+    }
+}
+
+// Issues the draw calls for a render list, templated so the submission can be measured against a null drawer
+template<typename Drawer>
+void SubmitRenderItems(Drawer* drawer, const std::vector<RenderItem>& items)
+{
+    for (auto& item : items)
+    {
+        SubmitRenderItem(drawer, item);
+    }
+}
+
+// Same with one item drawn as replacement instead, a negative index replaces none
+template<typename Drawer>
+void SubmitRenderItems(Drawer* drawer, const std::vector<RenderItem>& items, int replaced, const RenderItem& replacement)
+{
+    for (size_t i = 0; i < items.size(); i++)
+    {
+        SubmitRenderItem(drawer, (int) i == replaced ? replacement : items[i]);
+    }
+}
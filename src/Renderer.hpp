@@ -13,8 +13,12 @@ struct SpriteRenderer
     tako::Sprite* sprite;
 };
 
+// Which frame of which clip an entity shows, the clips themselves are defined in an AnimationSet
 struct AnimatedSprite
 {
     tako::Vector2 size;
-    tako::Sprite* sprites;
+    tako::U8 clip;
+    tako::U8 frame;
+    bool flip;
+    float time;
 };
\ No newline at end of file
@@ -0,0 +1,362 @@
+#pragma once
+#include "Tako.hpp"
+#include "AssetArchive.hpp"
+#include <chrono>
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+class ResourceCache;
+
+enum class ResourceKind
+{
+    Bitmap,
+    Texture,
+    Sprite,
+    Clip
+};
+
+// Kept per asset across evictions. Bytes are the decoded pixels the resource holds right now, clips are opaque
+struct ResourceStats
+{
+    int refs = 0;
+    int loads = 0;
+    int hits = 0;
+    int evictions = 0;
+    double loadMilliseconds = 0;
+    size_t bytes = 0;
+};
+
+template<typename T>
+struct ResourceEntry;
+
+// Counted reference to a cached resource, the last one going away frees it. A reload swaps what Get returns,
+// except for sprites which are overwritten in place so raw pointers handed to the renderer stay valid
+template<typename T>
+class Resource
+{
+public:
+    Resource() = default;
+    explicit Resource(ResourceEntry<T>* entry);
+    Resource(const Resource& other) : Resource(other.m_entry) {}
+    Resource(Resource&& other) noexcept : m_entry(std::exchange(other.m_entry, nullptr)) {}
+    ~Resource();
+
+    Resource& operator=(Resource other)
+    {
+        std::swap(m_entry, other.m_entry);
+        return *this;
+    }
+
+    T* Get() const;
+    int Width() const;
+    int Height() const;
+
+    T* operator->() const
+    {
+        return Get();
+    }
+
+    T& operator*() const
+    {
+        return *Get();
+    }
+
+    explicit operator bool() const
+    {
+        return m_entry;
+    }
+
+private:
+    ResourceEntry<T>* m_entry = nullptr;
+};
+
+template<typename T>
+struct ResourceEntry
+{
+    ResourceCache* cache;
+    ResourceStats* stats;
+    std::string key;
+    std::string path;
+    T* value = nullptr;
+    int refs = 0;
+    int width = 0;
+    int height = 0;
+    // Sprites only, the frame in their texture and the texture they keep alive
+    float x = 0, y = 0;
+    Resource<tako::Texture> texture;
+};
+
+// Assets loaded once per path and shared by everything that asks for them while any of it holds on. Sprites
+// are keyed by path and frame and share the texture of their image, textures are uploaded from the shared
+// bitmap. Resources must not outlive the cache
+class ResourceCache
+{
+public:
+    explicit ResourceCache(AssetArchive& archive) : m_archive(archive) {}
+    ResourceCache(const ResourceCache&) = delete;
+    ResourceCache& operator=(const ResourceCache&) = delete;
+
+    ~ResourceCache()
+    {
+        // Sprites first, dropping them releases the textures they hold
+        Free(m_sprites);
+        Free(m_textures);
+        Free(m_bitmaps);
+        Free(m_clips);
+        for (auto clip : m_retiredClips)
+        {
+            delete clip;
+        }
+    }
+
+    void Setup(tako::PixelArtDrawer* drawer)
+    {
+        m_drawer = drawer;
+    }
+
+    AssetArchive& Archive()
+    {
+        return m_archive;
+    }
+
+    Resource<tako::Bitmap> Bitmap(const char* file)
+    {
+        return Acquire(m_bitmaps, ResourceKind::Bitmap, file, file, [&](ResourceEntry<tako::Bitmap>& entry)
+        {
+            entry.value = new tako::Bitmap(LoadBitmap(m_archive, file));
+            SetSize(entry, entry.value->Width(), entry.value->Height());
+        });
+    }
+
+    Resource<tako::Texture> Texture(const char* file)
+    {
+        return Acquire(m_textures, ResourceKind::Texture, file, file, [&](ResourceEntry<tako::Texture>& entry)
+        {
+            auto bitmap = Bitmap(file);
+            entry.value = m_drawer->CreateTexture(*bitmap);
+            SetSize(entry, bitmap.Width(), bitmap.Height());
+        });
+    }
+
+    Resource<tako::Sprite> Sprite(const char* file, float x, float y, float w, float h)
+    {
+        auto key = std::string(file) + '#' + std::to_string((int) x) + ',' + std::to_string((int) y) + ',' + std::to_string((int) w) + ',' + std::to_string((int) h);
+        return Acquire(m_sprites, ResourceKind::Sprite, file, std::move(key), [&](ResourceEntry<tako::Sprite>& entry)
+        {
+            entry.texture = Texture(file);
+            entry.x = x;
+            entry.y = y;
+            entry.value = m_drawer->CreateSprite(entry.texture.Get(), x, y, w, h);
+            entry.width = w;
+            entry.height = h;
+        });
+    }
+
+    Resource<tako::AudioClip> Clip(const char* file)
+    {
+        return Acquire(m_clips, ResourceKind::Clip, file, file, [&](ResourceEntry<tako::AudioClip>& entry)
+        {
+            entry.value = new tako::AudioClip(file);
+        });
+    }
+
+    // Loads a changed asset again into everything made from it. Replaced clips are kept until the cache goes away,
+    // they may still be playing
+    void Reload(const char* file)
+    {
+        Reload(m_bitmaps, file, [&](ResourceEntry<tako::Bitmap>& entry)
+        {
+            *entry.value = LoadBitmap(m_archive, file);
+            SetSize(entry, entry.value->Width(), entry.value->Height());
+        });
+        Reload(m_textures, file, [&](ResourceEntry<tako::Texture>& entry)
+        {
+            auto bitmap = Bitmap(file);
+            delete entry.value;
+            entry.value = m_drawer->CreateTexture(*bitmap);
+            SetSize(entry, bitmap.Width(), bitmap.Height());
+        });
+        for (auto& [key, entry] : m_sprites)
+        {
+            if (entry->path == file)
+            {
+                auto sprite = m_drawer->CreateSprite(entry->texture.Get(), entry->x, entry->y, entry->width, entry->height);
+                *entry->value = *sprite;
+                delete sprite;
+            }
+        }
+        Reload(m_clips, file, [&](ResourceEntry<tako::AudioClip>& entry)
+        {
+            m_retiredClips.push_back(entry.value);
+            entry.value = new tako::AudioClip(file);
+        });
+    }
+
+    // Resources loaded right now
+    size_t Count() const
+    {
+        return m_bitmaps.size() + m_textures.size() + m_sprites.size() + m_clips.size();
+    }
+
+    // Every asset ever asked for, sprites by path and frame
+    template<typename Visit>
+    void ForEachStat(Visit visit) const
+    {
+        for (auto& [key, stats] : m_stats)
+        {
+            visit(key.first, key.second, stats);
+        }
+    }
+
+private:
+    template<typename T>
+    friend class Resource;
+
+    template<typename T>
+    using EntryMap = std::unordered_map<std::string, std::unique_ptr<ResourceEntry<T>>>;
+
+    template<typename T>
+    EntryMap<T>& Pool()
+    {
+        if constexpr (std::is_same_v<T, tako::Bitmap>)
+        {
+            return m_bitmaps;
+        }
+        else if constexpr (std::is_same_v<T, tako::Texture>)
+        {
+            return m_textures;
+        }
+        else if constexpr (std::is_same_v<T, tako::Sprite>)
+        {
+            return m_sprites;
+        }
+        else
+        {
+            return m_clips;
+        }
+    }
+
+    template<typename T>
+    void Release(ResourceEntry<T>* entry)
+    {
+        entry->stats->refs--;
+        if (--entry->refs > 0)
+        {
+            return;
+        }
+        entry->stats->evictions++;
+        entry->stats->bytes = 0;
+        delete entry->value;
+        // Taken out before it is destroyed, destroying a sprite releases its texture and may evict that too
+        auto node = Pool<T>().extract(entry->key);
+    }
+
+    template<typename T, typename Load>
+    Resource<T> Acquire(EntryMap<T>& pool, ResourceKind kind, const char* path, std::string key, Load&& load)
+    {
+        auto found = pool.find(key);
+        if (found != pool.end())
+        {
+            found->second->stats->hits++;
+            return Resource<T>(found->second.get());
+        }
+        auto& stats = m_stats[{kind, key}];
+        auto entry = std::make_unique<ResourceEntry<T>>();
+        entry->cache = this;
+        entry->stats = &stats;
+        entry->key = key;
+        entry->path = path;
+        auto start = std::chrono::steady_clock::now();
+        load(*entry);
+        stats.loads++;
+        stats.loadMilliseconds += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        auto loaded = entry.get();
+        pool.emplace(std::move(key), std::move(entry));
+        return Resource<T>(loaded);
+    }
+
+    template<typename T, typename Load>
+    void Reload(EntryMap<T>& pool, const char* file, Load&& load)
+    {
+        auto found = pool.find(file);
+        if (found == pool.end())
+        {
+            return;
+        }
+        auto& entry = *found->second;
+        auto start = std::chrono::steady_clock::now();
+        load(entry);
+        entry.stats->loads++;
+        entry.stats->loadMilliseconds += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    template<typename T>
+    static void SetSize(ResourceEntry<T>& entry, int width, int height)
+    {
+        entry.width = width;
+        entry.height = height;
+        entry.stats->bytes = size_t(width) * height * 4;
+    }
+
+    template<typename T>
+    void Free(EntryMap<T>& pool)
+    {
+        for (auto& [key, entry] : pool)
+        {
+            delete entry->value;
+        }
+        pool.clear();
+    }
+
+    AssetArchive& m_archive;
+    tako::PixelArtDrawer* m_drawer = nullptr;
+    EntryMap<tako::Bitmap> m_bitmaps;
+    EntryMap<tako::Texture> m_textures;
+    EntryMap<tako::Sprite> m_sprites;
+    EntryMap<tako::AudioClip> m_clips;
+    std::map<std::pair<ResourceKind, std::string>, ResourceStats> m_stats;
+    std::vector<tako::AudioClip*> m_retiredClips;
+};
+
+template<typename T>
+Resource<T>::Resource(ResourceEntry<T>* entry) : m_entry(entry)
+{
+    if (m_entry)
+    {
+        m_entry->refs++;
+        m_entry->stats->refs++;
+    }
+}
+
+template<typename T>
+Resource<T>::~Resource()
+{
+    if (m_entry)
+    {
+        m_entry->cache->Release(m_entry);
+    }
+}
+
+template<typename T>
+T* Resource<T>::Get() const
+{
+    return m_entry ? m_entry->value : nullptr;
+}
+
+template<typename T>
+int Resource<T>::Width() const
+{
+    return m_entry ? m_entry->width : 0;
+}
+
+template<typename T>
+int Resource<T>::Height() const
+{
+    return m_entry ? m_entry->height : 0;
+}
@@ -0,0 +1,203 @@
+#pragma once
+#include "Tako.hpp"
+#include "Player.hpp"
+#include "Random.hpp"
+#include <vector>
+#include <deque>
+#include <algorithm>
+
+namespace
+{
+    constexpr auto maxPredictedFrames = 8;
+}
+
+// Local inputs a peer has not seen acknowledged yet, plus how many inputs of the receiver the sender already has
+struct InputPacket
+{
+    int slot;
+    int ack;
+    int firstFrame;
+    std::vector<PlayerInput> inputs;
+};
+
+// Runs a lockstep simulation ahead of the remote inputs by predicting them.
+// The state after the last frame every input is known for is kept, and whenever more inputs get confirmed the
+// simulation is restored to it and stepped forward again, so every peer steps the confirmed frames from the same state.
+// Simulation provides Step(const PlayerInput* inputs, int count), SaveState(State&), LoadState(State&) and SetReplaying(bool)
+template<typename Simulation, typename State>
+class RollbackSession
+{
+public:
+    void Setup(Simulation* simulation, int players, int localSlot)
+    {
+        m_simulation = simulation;
+        m_localSlot = localSlot;
+        m_inputs.assign(players, {});
+        m_acked.assign(players, 0);
+        m_stepInputs.assign(players, 0);
+        m_frame = 0;
+        m_savedFrame = 0;
+        m_resimulated = 0;
+        simulation->SaveState(m_saved);
+    }
+
+    // Steps one frame with the local input, returns false without stepping while too far ahead of the confirmed inputs
+    bool Advance(PlayerInput input)
+    {
+        int confirmed = m_frame + 1;
+        for (int slot = 0; slot < m_inputs.size(); slot++)
+        {
+            if (slot != m_localSlot)
+            {
+                confirmed = std::min(confirmed, (int) m_inputs[slot].size());
+            }
+        }
+        if (m_frame - confirmed >= maxPredictedFrames)
+        {
+            return false;
+        }
+        m_inputs[m_localSlot].push_back(input);
+
+        int start = m_frame;
+        m_resimulated = 0;
+        if (confirmed > m_savedFrame)
+        {
+            m_simulation->LoadState(m_saved);
+            for (int frame = m_savedFrame; frame < confirmed; frame++)
+            {
+                StepFrame(frame);
+            }
+            // Predictions go on from the stepped world, only the confirmed path has to start from a restore
+            m_simulation->SaveState(m_saved);
+            m_savedFrame = confirmed;
+            start = confirmed;
+        }
+        for (int frame = start; frame <= m_frame; frame++)
+        {
+            StepFrame(frame);
+        }
+        m_frame++;
+        return true;
+    }
+
+    InputPacket MakePacket(int remoteSlot)
+    {
+        auto& local = m_inputs[m_localSlot];
+        int first = std::min(m_acked[remoteSlot], (int) local.size());
+        return {m_localSlot, (int) m_inputs[remoteSlot].size(), first, {local.begin() + first, local.end()}};
+    }
+
+    void Receive(const InputPacket& packet)
+    {
+        m_acked[packet.slot] = std::max(m_acked[packet.slot], packet.ack);
+        auto& inputs = m_inputs[packet.slot];
+        for (int i = 0; i < packet.inputs.size(); i++)
+        {
+            if (packet.firstFrame + i == inputs.size())
+            {
+                inputs.push_back(packet.inputs[i]);
+            }
+        }
+    }
+
+    int Frame()
+    {
+        return m_frame;
+    }
+
+    int ConfirmedFrame()
+    {
+        return m_savedFrame;
+    }
+
+    // Frames stepped again during the last Advance because their inputs changed from predicted to confirmed
+    int Resimulated()
+    {
+        return m_resimulated;
+    }
+
+    State& ConfirmedState()
+    {
+        return m_saved;
+    }
+
+private:
+    void StepFrame(int frame)
+    {
+        for (int slot = 0; slot < m_inputs.size(); slot++)
+        {
+            auto& inputs = m_inputs[slot];
+            if (frame < inputs.size())
+            {
+                m_stepInputs[slot] = inputs[frame];
+            }
+            else
+            {
+                m_stepInputs[slot] = inputs.empty() ? 0 : inputs.back() & ~InputButton::OneShot;
+            }
+        }
+        bool replaying = frame < m_frame;
+        m_resimulated += replaying;
+        m_simulation->SetReplaying(replaying);
+        m_simulation->Step(m_stepInputs.data(), m_stepInputs.size());
+        m_simulation->SetReplaying(false);
+    }
+
+    Simulation* m_simulation = nullptr;
+    int m_localSlot = 0;
+    int m_frame = 0;
+    int m_savedFrame = 0;
+    int m_resimulated = 0;
+    State m_saved;
+    std::vector<std::vector<PlayerInput>> m_inputs;
+    std::vector<int> m_acked;
+    std::vector<PlayerInput> m_stepInputs;
+};
+
+// In-process channel that delivers packets a fixed number of ticks late and drops some of them
+class LoopbackTransport
+{
+public:
+    LoopbackTransport(int latency, float lossRate, tako::U32 seed) : m_latency(latency), m_lossRate(lossRate)
+    {
+        m_random.Seed(seed);
+    }
+
+    void Send(const InputPacket& packet)
+    {
+        if (m_random.Value() < m_lossRate)
+        {
+            return;
+        }
+        m_queue.push_back({m_now + m_latency, packet});
+    }
+
+    bool Receive(InputPacket& packet)
+    {
+        if (m_queue.empty() || m_queue.front().deliverAt > m_now)
+        {
+            return false;
+        }
+        packet = std::move(m_queue.front().packet);
+        m_queue.pop_front();
+        return true;
+    }
+
+    void Tick()
+    {
+        m_now++;
+    }
+
+private:
+    struct Delivery
+    {
+        int deliverAt;
+        InputPacket packet;
+    };
+
+    int m_latency;
+    float m_lossRate;
+    int m_now = 0;
+    Random m_random;
+    std::deque<Delivery> m_queue;
+};
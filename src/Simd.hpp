@@ -0,0 +1,254 @@
+#pragma once
+#include "Tako.hpp"
+#include "Rect.hpp"
+#include <cstddef>
+#include <cmath>
+#if defined(__x86_64__) || defined(_M_X64)
+#define LD46_SIMD_X86
+#include <immintrin.h>
+#if defined(__GNUC__) || defined(__clang__)
+#define LD46_SIMD_AVX2
+#endif
+#endif
+
+// Batch kernels over packed (structure of arrays) data, picked once at runtime from what the CPU supports
+namespace Simd
+{
+    using OverlapKernel = void (*)(Rect rect, const float* x, const float* y, const float* w, const float* h, size_t count, tako::U8* hits);
+    using IntegrateKernel = void (*)(const float* x, const float* y, const float* vx, float* vy, float* tx, float* ty, size_t count, float dt, float gravity);
+    using BlendKernel = void (*)(tako::Color* dst, const tako::Color* src, size_t count);
+
+    // Rounded x / 255 for x up to 255 * 255, the vector kernels use the same shifts so every path gives equal pixels
+    tako::U32 Div255(tako::U32 x)
+    {
+        x += 128;
+        return (x + (x >> 8)) >> 8;
+    }
+
+    void OverlapScalar(Rect rect, const float* x, const float* y, const float* w, const float* h, size_t count, tako::U8* hits)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            hits[i] = std::abs(rect.x - x[i]) < rect.w / 2 + w[i] / 2 && std::abs(rect.y - y[i]) < rect.h / 2 + h[i] / 2;
+        }
+    }
+
+    void IntegrateScalar(const float* x, const float* y, const float* vx, float* vy, float* tx, float* ty, size_t count, float dt, float gravity)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            tx[i] = x[i] + vx[i] * dt;
+            ty[i] = y[i] + vy[i] * dt;
+            vy[i] -= gravity * dt;
+        }
+    }
+
+    // Source over blend of a row of pixels by their own alpha, the result is opaque where either side was
+    void BlendRowScalar(tako::Color* dst, const tako::Color* src, size_t count)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            tako::U32 a = src[i].a;
+            if (a == 0)
+            {
+                continue;
+            }
+            tako::U32 inv = 255 - a;
+            dst[i].r = Div255(src[i].r * a + dst[i].r * inv);
+            dst[i].g = Div255(src[i].g * a + dst[i].g * inv);
+            dst[i].b = Div255(src[i].b * a + dst[i].b * inv);
+            dst[i].a = Div255(255 * a + dst[i].a * inv);
+        }
+    }
+
+#ifdef LD46_SIMD_X86
+    void BlendRowSSE(tako::Color* dst, const tako::Color* src, size_t count)
+    {
+        static_assert(sizeof(tako::Color) == 4, "Pixels are blended as packed 32 bit values");
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i full = _mm_set1_epi16(255);
+        const __m128i round = _mm_set1_epi16(128);
+        const __m128i alphaOne = _mm_set_epi16(255, 0, 0, 0, 255, 0, 0, 0);
+        const __m128i alphaKeep = _mm_set_epi16(0, -1, -1, -1, 0, -1, -1, -1);
+        auto blend = [&](__m128i s, __m128i d)
+        {
+            __m128i a = _mm_shufflehi_epi16(_mm_shufflelo_epi16(s, 0xff), 0xff);
+            s = _mm_or_si128(_mm_and_si128(s, alphaKeep), alphaOne);
+            __m128i x = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(s, a), _mm_mullo_epi16(d, _mm_sub_epi16(full, a))), round);
+            return _mm_srli_epi16(_mm_add_epi16(x, _mm_srli_epi16(x, 8)), 8);
+        };
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4)
+        {
+            __m128i s = _mm_loadu_si128((const __m128i*) (src + i));
+            __m128i d = _mm_loadu_si128((const __m128i*) (dst + i));
+            __m128i lo = blend(_mm_unpacklo_epi8(s, zero), _mm_unpacklo_epi8(d, zero));
+            __m128i hi = blend(_mm_unpackhi_epi8(s, zero), _mm_unpackhi_epi8(d, zero));
+            _mm_storeu_si128((__m128i*) (dst + i), _mm_packus_epi16(lo, hi));
+        }
+        BlendRowScalar(dst + i, src + i, count - i);
+    }
+
+    void OverlapSSE(Rect rect, const float* x, const float* y, const float* w, const float* h, size_t count, tako::U8* hits)
+    {
+        const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+        const __m128 half = _mm_set1_ps(0.5f);
+        const __m128 rx = _mm_set1_ps(rect.x);
+        const __m128 ry = _mm_set1_ps(rect.y);
+        const __m128 rw = _mm_set1_ps(rect.w / 2);
+        const __m128 rh = _mm_set1_ps(rect.h / 2);
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4)
+        {
+            __m128 dx = _mm_and_ps(_mm_sub_ps(rx, _mm_loadu_ps(x + i)), absMask);
+            __m128 dy = _mm_and_ps(_mm_sub_ps(ry, _mm_loadu_ps(y + i)), absMask);
+            __m128 ex = _mm_add_ps(rw, _mm_mul_ps(_mm_loadu_ps(w + i), half));
+            __m128 ey = _mm_add_ps(rh, _mm_mul_ps(_mm_loadu_ps(h + i), half));
+            int mask = _mm_movemask_ps(_mm_and_ps(_mm_cmplt_ps(dx, ex), _mm_cmplt_ps(dy, ey)));
+            hits[i] = mask & 1;
+            hits[i + 1] = (mask >> 1) & 1;
+            hits[i + 2] = (mask >> 2) & 1;
+            hits[i + 3] = (mask >> 3) & 1;
+        }
+        OverlapScalar(rect, x + i, y + i, w + i, h + i, count - i, hits + i);
+    }
+
+    void IntegrateSSE(const float* x, const float* y, const float* vx, float* vy, float* tx, float* ty, size_t count, float dt, float gravity)
+    {
+        const __m128 step = _mm_set1_ps(dt);
+        const __m128 fall = _mm_set1_ps(gravity * dt);
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4)
+        {
+            __m128 speedY = _mm_loadu_ps(vy + i);
+            _mm_storeu_ps(tx + i, _mm_add_ps(_mm_loadu_ps(x + i), _mm_mul_ps(_mm_loadu_ps(vx + i), step)));
+            _mm_storeu_ps(ty + i, _mm_add_ps(_mm_loadu_ps(y + i), _mm_mul_ps(speedY, step)));
+            _mm_storeu_ps(vy + i, _mm_sub_ps(speedY, fall));
+        }
+        IntegrateScalar(x + i, y + i, vx + i, vy + i, tx + i, ty + i, count - i, dt, gravity);
+    }
+#endif
+
+#ifdef LD46_SIMD_AVX2
+    __attribute__((target("avx2"))) void OverlapAVX2(Rect rect, const float* x, const float* y, const float* w, const float* h, size_t count, tako::U8* hits)
+    {
+        const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+        const __m256 half = _mm256_set1_ps(0.5f);
+        const __m256 rx = _mm256_set1_ps(rect.x);
+        const __m256 ry = _mm256_set1_ps(rect.y);
+        const __m256 rw = _mm256_set1_ps(rect.w / 2);
+        const __m256 rh = _mm256_set1_ps(rect.h / 2);
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8)
+        {
+            __m256 dx = _mm256_and_ps(_mm256_sub_ps(rx, _mm256_loadu_ps(x + i)), absMask);
+            __m256 dy = _mm256_and_ps(_mm256_sub_ps(ry, _mm256_loadu_ps(y + i)), absMask);
+            __m256 ex = _mm256_add_ps(rw, _mm256_mul_ps(_mm256_loadu_ps(w + i), half));
+            __m256 ey = _mm256_add_ps(rh, _mm256_mul_ps(_mm256_loadu_ps(h + i), half));
+            int mask = _mm256_movemask_ps(_mm256_and_ps(_mm256_cmp_ps(dx, ex, _CMP_LT_OQ), _mm256_cmp_ps(dy, ey, _CMP_LT_OQ)));
+            for (int lane = 0; lane < 8; lane++)
+            {
+                hits[i + lane] = (mask >> lane) & 1;
+            }
+        }
+        OverlapSSE(rect, x + i, y + i, w + i, h + i, count - i, hits + i);
+    }
+
+    __attribute__((target("avx2"))) void IntegrateAVX2(const float* x, const float* y, const float* vx, float* vy, float* tx, float* ty, size_t count, float dt, float gravity)
+    {
+        const __m256 step = _mm256_set1_ps(dt);
+        const __m256 fall = _mm256_set1_ps(gravity * dt);
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8)
+        {
+            __m256 speedY = _mm256_loadu_ps(vy + i);
+            _mm256_storeu_ps(tx + i, _mm256_add_ps(_mm256_loadu_ps(x + i), _mm256_mul_ps(_mm256_loadu_ps(vx + i), step)));
+            _mm256_storeu_ps(ty + i, _mm256_add_ps(_mm256_loadu_ps(y + i), _mm256_mul_ps(speedY, step)));
+            _mm256_storeu_ps(vy + i, _mm256_sub_ps(speedY, fall));
+        }
+        IntegrateSSE(x + i, y + i, vx + i, vy + i, tx + i, ty + i, count - i, dt, gravity);
+    }
+#endif
+
+    bool HasAVX2()
+    {
+#ifdef LD46_SIMD_AVX2
+        static bool supported = __builtin_cpu_supports("avx2");
+        return supported;
+#else
+        return false;
+#endif
+    }
+
+    const char* KernelName()
+    {
+#ifdef LD46_SIMD_AVX2
+        if (HasAVX2())
+        {
+            return "avx2";
+        }
+#endif
+#ifdef LD46_SIMD_X86
+        return "sse";
+#else
+        return "scalar";
+#endif
+    }
+
+    OverlapKernel SelectOverlap()
+    {
+#ifdef LD46_SIMD_AVX2
+        if (HasAVX2())
+        {
+            return OverlapAVX2;
+        }
+#endif
+#ifdef LD46_SIMD_X86
+        return OverlapSSE;
+#else
+        return OverlapScalar;
+#endif
+    }
+
+    IntegrateKernel SelectIntegrate()
+    {
+#ifdef LD46_SIMD_AVX2
+        if (HasAVX2())
+        {
+            return IntegrateAVX2;
+        }
+#endif
+#ifdef LD46_SIMD_X86
+        return IntegrateSSE;
+#else
+        return IntegrateScalar;
+#endif
+    }
+
+    BlendKernel SelectBlendRow()
+    {
+#ifdef LD46_SIMD_X86
+        return BlendRowSSE;
+#else
+        return BlendRowScalar;
+#endif
+    }
+
+    void BlendRow(tako::Color* dst, const tako::Color* src, size_t count)
+    {
+        static BlendKernel kernel = SelectBlendRow();
+        kernel(dst, src, count);
+    }
+
+    void Overlap(Rect rect, const float* x, const float* y, const float* w, const float* h, size_t count, tako::U8* hits)
+    {
+        static OverlapKernel kernel = SelectOverlap();
+        kernel(rect, x, y, w, h, count, hits);
+    }
+
+    void Integrate(const float* x, const float* y, const float* vx, float* vy, float* tx, float* ty, size_t count, float dt, float gravity)
+    {
+        static IntegrateKernel kernel = SelectIntegrate();
+        kernel(x, y, vx, vy, tx, ty, count, dt, gravity);
+    }
+}
@@ -0,0 +1,289 @@
+#pragma once
+#include "Tako.hpp"
+#include "Simd.hpp"
+#include <vector>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cmath>
+#include <cstdio>
+#include <algorithm>
+
+// CPU implementation of the PixelArtDrawer calls the game makes, for render tests and headless runs without a GPU.
+// Draw calls are recorded with the camera applied and rasterized by Present, split into horizontal bands that are
+// drawn by a pool of worker threads. Every band replays all calls in order, so the result doesn't depend on the thread count
+class SoftwareDrawer
+{
+public:
+    struct Texture
+    {
+        int width;
+        int height;
+        std::vector<tako::Color> pixels;
+    };
+
+    // A negative width or height reads the region mirrored, starting from the far edge
+    struct Sprite
+    {
+        Texture* texture;
+        float x, y, w, h;
+    };
+
+    SoftwareDrawer(int threads = 1) : m_threads(std::max(1, threads))
+    {
+        for (int band = 1; band < m_threads; band++)
+        {
+            m_workers.emplace_back([this, band] { Work(band); });
+        }
+    }
+
+    ~SoftwareDrawer()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopping = true;
+        }
+        m_wake.notify_all();
+        for (auto& worker : m_workers)
+        {
+            worker.join();
+        }
+    }
+
+    SoftwareDrawer(const SoftwareDrawer&) = delete;
+    SoftwareDrawer& operator=(const SoftwareDrawer&) = delete;
+
+    void SetTargetSize(int width, int height)
+    {
+        m_width = width;
+        m_height = height;
+        m_pixels.assign(width * height, m_clearColor);
+    }
+
+    tako::Vector2 GetCameraViewSize()
+    {
+        return tako::Vector2(m_width, m_height);
+    }
+
+    Texture* CreateTexture(const tako::Color* pixels, int width, int height)
+    {
+        m_textures.push_back(std::make_unique<Texture>(Texture{width, height, {pixels, pixels + width * height}}));
+        return m_textures.back().get();
+    }
+
+    Texture* CreateTexture(const tako::Bitmap& bitmap)
+    {
+        std::vector<tako::Color> pixels(bitmap.Width() * bitmap.Height());
+        for (int y = 0; y < bitmap.Height(); y++)
+        {
+            for (int x = 0; x < bitmap.Width(); x++)
+            {
+                pixels[y * bitmap.Width() + x] = bitmap.GetPixel(x, y);
+            }
+        }
+        return CreateTexture(pixels.data(), bitmap.Width(), bitmap.Height());
+    }
+
+    Sprite* CreateSprite(Texture* texture, float x, float y, float w, float h)
+    {
+        m_sprites.push_back(std::make_unique<Sprite>(Sprite{texture, x, y, w, h}));
+        return m_sprites.back().get();
+    }
+
+    void Clear()
+    {
+        m_commands.clear();
+    }
+
+    void SetCameraPosition(tako::Vector2 position)
+    {
+        m_camera = position;
+    }
+
+    void DrawImage(float x, float y, float w, float h, Texture* texture)
+    {
+        Record(x, y, w, h, texture, {0, 0, (float) texture->width, (float) texture->height}, {255, 255, 255, 255});
+    }
+
+    void DrawSprite(float x, float y, float w, float h, Sprite* sprite)
+    {
+        Record(x, y, w, h, sprite->texture, {sprite->x, sprite->y, sprite->w, sprite->h}, {255, 255, 255, 255});
+    }
+
+    void DrawRectangle(float x, float y, float w, float h, tako::Color color)
+    {
+        Record(x, y, w, h, nullptr, {}, color);
+    }
+
+    // Rasterizes everything recorded since the last Clear over the clear color
+    void Present()
+    {
+        if (m_workers.empty())
+        {
+            DrawBand(0);
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_pending = m_workers.size();
+            m_generation++;
+        }
+        m_wake.notify_all();
+        DrawBand(0);
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_done.wait(lock, [this] { return m_pending == 0; });
+    }
+
+    const tako::Color* Pixels() const
+    {
+        return m_pixels.data();
+    }
+
+    int Width() const
+    {
+        return m_width;
+    }
+
+    int Height() const
+    {
+        return m_height;
+    }
+
+    // Binary PPM of the last presented frame, alpha is dropped
+    bool WritePpm(const char* file) const
+    {
+        FILE* out = fopen(file, "wb");
+        if (!out)
+        {
+            return false;
+        }
+        fprintf(out, "P6\n%d %d\n255\n", m_width, m_height);
+        for (auto& pixel : m_pixels)
+        {
+            tako::U8 rgb[3] = {pixel.r, pixel.g, pixel.b};
+            fwrite(rgb, 1, 3, out);
+        }
+        return fclose(out) == 0;
+    }
+
+private:
+    struct Region
+    {
+        float x, y, w, h;
+    };
+
+    struct Command
+    {
+        int left, top, width, height;
+        const Texture* texture;
+        Region source;
+        tako::Color color;
+    };
+
+    // Positions are in world units with y up, relative to the camera in the center of the view
+    void Record(float x, float y, float w, float h, const Texture* texture, Region source, tako::Color color)
+    {
+        int left = std::floor(x - m_camera.x + m_width / 2.0f + 0.5f);
+        int top = std::floor(m_camera.y + m_height / 2.0f - y + 0.5f);
+        int width = std::floor(w + 0.5f);
+        int height = std::floor(h + 0.5f);
+        if (width <= 0 || height <= 0 || left >= m_width || top >= m_height || left + width <= 0 || top + height <= 0)
+        {
+            return;
+        }
+        m_commands.push_back({left, top, width, height, texture, source, color});
+    }
+
+    void Work(int band)
+    {
+        size_t seen = 0;
+        while (true)
+        {
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_wake.wait(lock, [&] { return m_stopping || m_generation != seen; });
+                if (m_stopping)
+                {
+                    return;
+                }
+                seen = m_generation;
+            }
+            DrawBand(band);
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (--m_pending == 0)
+            {
+                m_done.notify_one();
+            }
+        }
+    }
+
+    void DrawBand(int band)
+    {
+        int begin = m_height * band / m_threads;
+        int end = m_height * (band + 1) / m_threads;
+        auto& row = m_rows[band];
+        row.resize(m_width);
+        std::fill(m_pixels.begin() + begin * m_width, m_pixels.begin() + end * m_width, m_clearColor);
+        for (auto& command : m_commands)
+        {
+            int x0 = std::max(0, command.left);
+            int x1 = std::min(m_width, command.left + command.width);
+            int y0 = std::max(begin, command.top);
+            int y1 = std::min(end, command.top + command.height);
+            if (x0 >= x1 || y0 >= y1)
+            {
+                continue;
+            }
+            auto& source = command.source;
+            auto texture = command.texture;
+            for (int y = y0; y < y1; y++)
+            {
+                auto dst = m_pixels.data() + y * m_width + x0;
+                if (!texture)
+                {
+                    std::fill(row.begin(), row.begin() + (x1 - x0), command.color);
+                    Simd::BlendRow(dst, row.data(), x1 - x0);
+                    continue;
+                }
+                int sy = Sample(source.y, source.h, y - command.top, command.height, texture->height);
+                auto srcRow = texture->pixels.data() + sy * texture->width;
+                if (source.w == command.width && source.x >= 0 && source.x + source.w <= texture->width)
+                {
+                    Simd::BlendRow(dst, srcRow + (int) source.x + (x0 - command.left), x1 - x0);
+                    continue;
+                }
+                for (int x = x0; x < x1; x++)
+                {
+                    row[x - x0] = srcRow[Sample(source.x, source.w, x - command.left, command.width, texture->width)];
+                }
+                Simd::BlendRow(dst, row.data(), x1 - x0);
+            }
+        }
+    }
+
+    // Nearest texel for a destination pixel, taken at the pixel center so mirrored regions map one to one
+    static int Sample(float start, float length, int offset, int size, int limit)
+    {
+        int texel = std::floor(start + (offset + 0.5f) * length / size);
+        return std::clamp(texel, 0, limit - 1);
+    }
+
+    int m_threads;
+    int m_width = 0;
+    int m_height = 0;
+    tako::Vector2 m_camera;
+    tako::Color m_clearColor = {0, 0, 0, 255};
+    std::vector<tako::Color> m_pixels;
+    std::vector<Command> m_commands;
+    std::vector<std::unique_ptr<Texture>> m_textures;
+    std::vector<std::unique_ptr<Sprite>> m_sprites;
+    std::vector<std::vector<tako::Color>> m_rows{size_t(m_threads)};
+    std::vector<std::thread> m_workers;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_done;
+    size_t m_generation = 0;
+    size_t m_pending = 0;
+    bool m_stopping = false;
+};
@@ -0,0 +1,136 @@
+#pragma once
+#include "Tako.hpp"
+#include <vector>
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+    constexpr auto maxActiveVoices = 8;
+}
+
+enum class SoundPriority
+{
+    Low,
+    Normal,
+    High
+};
+
+struct SoundSettings
+{
+    float length;
+    int maxVoices;
+    SoundPriority priority;
+};
+
+// Playing time of an uncompressed wav taken from its header, zero when the file can't be read as one
+float WavLength(const char* file)
+{
+    tako::U8 header[256];
+    size_t bytesRead = 0;
+    if (!tako::FileSystem::ReadFile(file, header, sizeof(header), bytesRead) || bytesRead < 12 ||
+        std::memcmp(header, "RIFF", 4) != 0 || std::memcmp(header + 8, "WAVE", 4) != 0)
+    {
+        return 0;
+    }
+    auto read32 = [&](size_t at)
+    {
+        return header[at] | header[at + 1] << 8 | header[at + 2] << 16 | tako::U32(header[at + 3]) << 24;
+    };
+    tako::U32 byteRate = 0;
+    for (size_t chunk = 12; chunk + 8 <= bytesRead;)
+    {
+        tako::U32 size = read32(chunk + 4);
+        if (std::memcmp(header + chunk, "fmt ", 4) == 0 && chunk + 20 <= bytesRead)
+        {
+            byteRate = read32(chunk + 16);
+        }
+        if (std::memcmp(header + chunk, "data", 4) == 0)
+        {
+            return byteRate ? float(size) / byteRate : 0;
+        }
+        chunk += 8 + size + (size & 1);
+    }
+    return 0;
+}
+
+// Collects the sounds requested during a frame and plays each clip at most once per frame,
+// limited by its own voice cap and the global voice budget
+class SoundMixer
+{
+public:
+    void Register(tako::AudioClip* clip, SoundSettings settings)
+    {
+        m_sounds.push_back({clip, settings, false, {}});
+        m_sounds.back().voices.reserve(settings.maxVoices);
+    }
+
+    void Replace(tako::AudioClip* clip, tako::AudioClip* replacement, float length)
+    {
+        for (auto& sound : m_sounds)
+        {
+            if (sound.clip == clip)
+            {
+                sound.clip = replacement;
+                sound.settings.length = length;
+            }
+        }
+    }
+
+    void Play(tako::AudioClip* clip)
+    {
+        for (auto& sound : m_sounds)
+        {
+            if (sound.clip == clip)
+            {
+                sound.requested = true;
+                return;
+            }
+        }
+        tako::Audio::Play(*clip);
+    }
+
+    void Flush(float dt)
+    {
+        int active = 0;
+        for (auto& sound : m_sounds)
+        {
+            for (auto& voice : sound.voices)
+            {
+                voice -= dt;
+            }
+            sound.voices.erase(std::remove_if(sound.voices.begin(), sound.voices.end(), [](float left) { return left <= 0; }), sound.voices.end());
+            active += sound.voices.size();
+        }
+
+        for (auto priority : {SoundPriority::High, SoundPriority::Normal, SoundPriority::Low})
+        {
+            for (auto& sound : m_sounds)
+            {
+                if (!sound.requested || sound.settings.priority != priority)
+                {
+                    continue;
+                }
+                sound.requested = false;
+                if ((int) sound.voices.size() >= sound.settings.maxVoices || (active >= maxActiveVoices && priority != SoundPriority::High))
+                {
+                    continue;
+                }
+                tako::Audio::Play(*sound.clip);
+                sound.voices.push_back(sound.settings.length);
+                active++;
+            }
+        }
+    }
+
+private:
+    struct Sound
+    {
+        tako::AudioClip* clip;
+        SoundSettings settings;
+        bool requested;
+        std::vector<float> voices;
+    };
+
+    std::vector<Sound> m_sounds;
+};
@@ -0,0 +1,151 @@
+#pragma once
+#include "Tako.hpp"
+#include "Level.hpp"
+#include <vector>
+#include <algorithm>
+#include <utility>
+
+enum class ChunkRecordType : tako::U8
+{
+    Plant,
+    Enemy,
+    DeadEnemy,
+    Spawner
+};
+
+// Compact form of an entity living in a chunk that is not loaded
+struct ChunkRecord
+{
+    ChunkRecordType type;
+    tako::Vector2 position;
+    tako::Vector2 speed;
+    float timer;
+    float value;
+    // Step the record was stored at, spawner timers keep running while their chunk is paged out
+    tako::U32 step = 0;
+};
+
+class ChunkStreamer
+{
+public:
+    void Setup(Level* level, int radius, std::vector<ChunkRecord>& records)
+    {
+        m_level = level;
+        m_radius = radius;
+        m_centers.clear();
+        m_chunksX = level->ChunksX();
+        m_chunksY = level->ChunksY();
+        m_records.assign(m_chunksX * m_chunksY, {});
+        m_active.assign(m_chunksX * m_chunksY, false);
+        m_activeChunks.clear();
+        for (auto& record : records)
+        {
+            Store(record);
+        }
+        for (int cy = 0; cy < m_chunksY; cy++)
+        {
+            for (int cx = 0; cx < m_chunksX; cx++)
+            {
+                level->UnloadChunk(cx, cy);
+            }
+        }
+    }
+
+    void Store(const ChunkRecord& record)
+    {
+        int chunk = ChunkIndex(record.position);
+        if (chunk >= 0)
+        {
+            m_records[chunk].push_back(record);
+        }
+    }
+
+    bool IsActive(tako::Vector2 position)
+    {
+        int chunk = ChunkIndex(position);
+        return chunk >= 0 && m_active[chunk];
+    }
+
+    // Pages in the chunks within the radius of any center and pages out the ones no center is near anymore,
+    // revive gets called for every record of a chunk that became active
+    template<typename Revive>
+    void Update(const std::vector<tako::Vector2>& centers, Revive&& revive)
+    {
+        m_nextCenters.clear();
+        for (auto center : centers)
+        {
+            m_nextCenters.emplace_back((int) std::floor(center.x / (chunkSize * 16)), (int) std::floor(center.y / (chunkSize * 16)));
+        }
+        if (m_nextCenters == m_centers)
+        {
+            return;
+        }
+        std::swap(m_centers, m_nextCenters);
+
+        auto inRadius = [&](int chunk)
+        {
+            int cx = chunk % m_chunksX;
+            int cy = chunk / m_chunksX;
+            return std::any_of(m_centers.begin(), m_centers.end(), [&](std::pair<int, int> center)
+            {
+                return std::abs(cx - center.first) <= m_radius && std::abs(cy - center.second) <= m_radius;
+            });
+        };
+        for (auto chunk : m_activeChunks)
+        {
+            if (!inRadius(chunk))
+            {
+                m_active[chunk] = false;
+                m_level->UnloadChunk(chunk % m_chunksX, chunk / m_chunksX);
+            }
+        }
+        m_activeChunks.erase(std::remove_if(m_activeChunks.begin(), m_activeChunks.end(), [&](int chunk) { return !m_active[chunk]; }), m_activeChunks.end());
+
+        for (auto [centerX, centerY] : m_centers)
+        {
+            for (int cy = std::max(0, centerY - m_radius); cy <= std::min(m_chunksY - 1, centerY + m_radius); cy++)
+            {
+                for (int cx = std::max(0, centerX - m_radius); cx <= std::min(m_chunksX - 1, centerX + m_radius); cx++)
+                {
+                    int chunk = cy * m_chunksX + cx;
+                    if (m_active[chunk])
+                    {
+                        continue;
+                    }
+                    m_active[chunk] = true;
+                    m_activeChunks.push_back(chunk);
+                    m_level->LoadChunk(cx, cy);
+                    for (auto& record : m_records[chunk])
+                    {
+                        revive(record);
+                    }
+                    m_records[chunk].clear();
+                    m_records[chunk].shrink_to_fit();
+                }
+            }
+        }
+    }
+
+private:
+    int ChunkIndex(tako::Vector2 position)
+    {
+        int cx = (int) std::floor(position.x / (chunkSize * 16));
+        int cy = (int) std::floor(position.y / (chunkSize * 16));
+        if (cx < 0 || cx >= m_chunksX || cy < 0 || cy >= m_chunksY)
+        {
+            return -1;
+        }
+        return cy * m_chunksX + cx;
+    }
+
+    Level* m_level = nullptr;
+    int m_radius = 1;
+    int m_chunksX = 0;
+    int m_chunksY = 0;
+    // Chunk every center was in at the last update
+    std::vector<std::pair<int, int>> m_centers;
+    std::vector<std::pair<int, int>> m_nextCenters;
+    std::vector<std::vector<ChunkRecord>> m_records;
+    std::vector<bool> m_active;
+    std::vector<int> m_activeChunks;
+};
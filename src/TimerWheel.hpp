@@ -0,0 +1,161 @@
+#pragma once
+#include "Tako.hpp"
+#include <array>
+#include <cstdint>
+#include <vector>
+
+struct TimerHandle
+{
+    tako::U32 index = ~0u;
+    tako::U32 generation = 0;
+};
+
+// Hashed timer wheel over simulation steps. A timer is linked into the slot of its due step modulo the slot count
+// and only looked at when that slot comes around, so a step without due timers costs a single slot lookup.
+// Timers more than a revolution out stay in their slot until the revolution they are due in
+template<typename Payload, size_t Slots = 1024>
+class TimerWheel
+{
+    static_assert((Slots & (Slots - 1)) == 0, "Slot count must be a power of two");
+public:
+    TimerWheel()
+    {
+        m_slots.fill(none);
+    }
+
+    // Drops every timer, the next Advance fires what is due in the step after step. Nodes are kept with a new
+    // generation so handles from before stay harmless
+    void Clear(tako::U32 step)
+    {
+        m_slots.fill(none);
+        m_free = none;
+        for (auto i = tako::U32(m_nodes.size()); i-- > 0;)
+        {
+            m_nodes[i].live = false;
+            Release(i);
+        }
+        m_step = step;
+        m_pending = 0;
+    }
+
+    void Reserve(size_t count)
+    {
+        m_nodes.reserve(count);
+    }
+
+    size_t Pending() const
+    {
+        return m_pending;
+    }
+
+    // Steps that already passed are due in the next one
+    TimerHandle Schedule(tako::U32 due, const Payload& payload)
+    {
+        if (Before(due, m_step + 1))
+        {
+            due = m_step + 1;
+        }
+        tako::U32 index = m_free;
+        if (index != none)
+        {
+            m_free = m_nodes[index].next;
+        }
+        else
+        {
+            index = m_nodes.size();
+            m_nodes.emplace_back();
+        }
+        auto& node = m_nodes[index];
+        auto& head = m_slots[due & (Slots - 1)];
+        node.due = due;
+        node.live = true;
+        node.payload = payload;
+        node.next = head;
+        head = index;
+        m_pending++;
+        return {index, node.generation};
+    }
+
+    // Cancelled timers stay linked until their slot comes around, handles of fired or cancelled timers are ignored
+    void Cancel(TimerHandle handle)
+    {
+        if (handle.index >= m_nodes.size())
+        {
+            return;
+        }
+        auto& node = m_nodes[handle.index];
+        if (node.live && node.generation == handle.generation)
+        {
+            node.live = false;
+            m_pending--;
+        }
+    }
+
+    // Moves on to step and fires every timer due up to it, fire may schedule new timers
+    template<typename Fire>
+    void Advance(tako::U32 step, Fire&& fire)
+    {
+        while (m_step != step)
+        {
+            m_step++;
+            auto& head = m_slots[m_step & (Slots - 1)];
+            tako::U32 index = head;
+            head = none;
+            while (index != none)
+            {
+                auto& node = m_nodes[index];
+                tako::U32 next = node.next;
+                if (node.live && Before(m_step, node.due))
+                {
+                    node.next = head;
+                    head = index;
+                }
+                else if (node.live)
+                {
+                    Payload payload = node.payload;
+                    node.live = false;
+                    m_pending--;
+                    Release(index);
+                    fire(payload);
+                }
+                else
+                {
+                    Release(index);
+                }
+                index = next;
+            }
+        }
+    }
+
+private:
+    static constexpr tako::U32 none = ~0u;
+
+    struct Node
+    {
+        tako::U32 due;
+        tako::U32 next;
+        tako::U32 generation = 0;
+        bool live = false;
+        Payload payload;
+    };
+
+    // Steps wrap around, anything less than half the range behind counts as earlier
+    static bool Before(tako::U32 a, tako::U32 b)
+    {
+        return int32_t(a - b) < 0;
+    }
+
+    void Release(tako::U32 index)
+    {
+        auto& node = m_nodes[index];
+        node.generation++;
+        node.next = m_free;
+        m_free = index;
+    }
+
+    std::vector<Node> m_nodes;
+    std::array<tako::U32, Slots> m_slots;
+    tako::U32 m_free = none;
+    tako::U32 m_step = 0;
+    size_t m_pending = 0;
+};
@@ -0,0 +1,176 @@
+#pragma once
+#include "Tako.hpp"
+#include "World.hpp"
+#include "ComponentCensus.hpp"
+#include <vector>
+#include <tuple>
+#include <utility>
+#include <unordered_map>
+#include <type_traits>
+#include <cstdlib>
+
+// Copy of every entity holding one of the listed components. Restoring into a fresh world recreates the
+// entities in the saved order, so worlds restored from equal snapshots iterate equally as well.
+// Every entity is created with all of its components at once, so each combination saved has to be added as a shape
+template<typename... Components>
+class WorldSnapshot
+{
+    static_assert(sizeof...(Components) <= 32, "Components must fit in the entity mask");
+
+public:
+    void Save(tako::World& world)
+    {
+        m_masks.clear();
+        m_index.clear();
+        std::apply([](auto&... pools) { (pools.clear(), ...); }, m_pools);
+        SaveAll(world, std::index_sequence_for<Components...>());
+    }
+
+    void Restore(tako::World& world)
+    {
+        m_restored.resize(m_masks.size());
+        const Shape* shape = nullptr;
+        for (int i = 0; i < m_masks.size(); i++)
+        {
+            if (!shape || shape->mask != m_masks[i])
+            {
+                shape = &FindShape(m_masks[i]);
+            }
+            m_restored[i] = shape->create(world);
+        }
+        RestoreAll(world, std::index_sequence_for<Components...>());
+    }
+
+    // Entities holding exactly these components get restored with a single Create
+    template<typename... Shaped>
+    void AddShape()
+    {
+        constexpr tako::U32 mask = ((1u << Index<Shaped>()) | ...);
+        for (auto& shape : m_shapes)
+        {
+            if (shape.mask == mask)
+            {
+                return;
+            }
+        }
+        m_shapes.push_back({mask, [](tako::World& world)
+        {
+            return world.template Create<Shaped...>();
+        }});
+    }
+
+    // Saving worlds within the given counts doesn't allocate
+    void Reserve(const ComponentCounts<Components...>& counts, size_t entities)
+    {
+        (std::get<Pool<Components>>(m_pools).reserve(counts.template Get<Components>()), ...);
+        m_masks.reserve(entities);
+        m_index.reserve(entities);
+        m_restored.reserve(entities);
+    }
+
+    // Entity handle stored in a component, as it is called in the world of the last restore
+    tako::Entity Restored(tako::Entity saved)
+    {
+        auto it = m_index.find(saved);
+        if (it == m_index.end())
+        {
+            LOG_ERR("Entity {} is not in the snapshot", saved);
+            std::abort();
+        }
+        return m_restored[it->second];
+    }
+
+    size_t EntityCount()
+    {
+        return m_masks.size();
+    }
+
+    template<typename T>
+    using Pool = std::vector<std::pair<int, T>>;
+
+    // Saved components of one type, paired with the index of the entity they belong to
+    template<typename T>
+    const Pool<T>& Saved()
+    {
+        return std::get<Pool<T>>(m_pools);
+    }
+
+private:
+    template<size_t... I>
+    void SaveAll(tako::World& world, std::index_sequence<I...>)
+    {
+        (SavePool<I>(world), ...);
+    }
+
+    template<size_t I>
+    void SavePool(tako::World& world)
+    {
+        using T = std::tuple_element_t<I, std::tuple<Components...>>;
+        auto& pool = std::get<I>(m_pools);
+        world.template IterateHandle<T>([&](tako::EntityHandle handle)
+        {
+            auto [it, inserted] = m_index.try_emplace(handle.id, (int) m_masks.size());
+            if (inserted)
+            {
+                m_masks.push_back(0);
+            }
+            m_masks[it->second] |= 1u << I;
+            pool.push_back({it->second, world.template GetComponent<T>(handle.id)});
+        });
+    }
+
+    struct Shape
+    {
+        tako::U32 mask;
+        tako::Entity (*create)(tako::World&);
+    };
+
+    const Shape& FindShape(tako::U32 mask)
+    {
+        for (auto& shape : m_shapes)
+        {
+            if (shape.mask == mask)
+            {
+                return shape;
+            }
+        }
+        LOG_ERR("No shape added for component mask {}", mask);
+        std::abort();
+    }
+
+    template<typename T, size_t I = 0>
+    static constexpr size_t Index()
+    {
+        static_assert(I < sizeof...(Components), "Component is not saved");
+        if constexpr (std::is_same_v<T, std::tuple_element_t<I, std::tuple<Components...>>>)
+        {
+            return I;
+        }
+        else
+        {
+            return Index<T, I + 1>();
+        }
+    }
+
+    template<size_t... I>
+    void RestoreAll(tako::World& world, std::index_sequence<I...>)
+    {
+        (RestorePool<I>(world), ...);
+    }
+
+    template<size_t I>
+    void RestorePool(tako::World& world)
+    {
+        using T = std::tuple_element_t<I, std::tuple<Components...>>;
+        for (auto& [index, component] : std::get<I>(m_pools))
+        {
+            world.template GetComponent<T>(m_restored[index]) = component;
+        }
+    }
+
+    std::vector<tako::U32> m_masks;
+    std::unordered_map<tako::Entity, int> m_index;
+    std::vector<tako::Entity> m_restored;
+    std::tuple<Pool<Components>...> m_pools;
+    std::vector<Shape> m_shapes;
+};
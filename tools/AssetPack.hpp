@@ -0,0 +1,181 @@
+#pragma once
+#include "AssetArchive.hpp"
+#include "Png.hpp"
+#include <array>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace AssetPack
+{
+    // Greedy LZ77 for the format read by Decompress, matches are found through a hash of the next four bytes
+    std::vector<tako::U8> Compress(const tako::U8* src, size_t size)
+    {
+        constexpr size_t minMatch = 4;
+        constexpr size_t maxOffset = 65535;
+        std::vector<tako::U8> out;
+        std::array<size_t, 4096> table;
+        table.fill(size_t(-1));
+        auto hash = [&](size_t i)
+        {
+            tako::U32 value;
+            memcpy(&value, src + i, 4);
+            return (value * 2654435761u) >> 20;
+        };
+        auto length = [&](size_t value)
+        {
+            for (value -= 15; value >= 255; value -= 255)
+            {
+                out.push_back(255);
+            }
+            out.push_back(value);
+        };
+        size_t anchor = 0;
+        size_t i = 0;
+        while (i + minMatch <= size)
+        {
+            auto& slot = table[hash(i)];
+            size_t candidate = slot;
+            slot = i;
+            if (candidate == size_t(-1) || i - candidate > maxOffset || memcmp(src + candidate, src + i, minMatch) != 0)
+            {
+                i++;
+                continue;
+            }
+            size_t match = minMatch;
+            while (i + match < size && src[candidate + match] == src[i + match])
+            {
+                match++;
+            }
+            size_t literals = i - anchor;
+            out.push_back(tako::U8((std::min<size_t>(literals, 15) << 4) | std::min<size_t>(match - minMatch, 15)));
+            if (literals >= 15)
+            {
+                length(literals);
+            }
+            out.insert(out.end(), src + anchor, src + i);
+            size_t offset = i - candidate;
+            out.push_back(offset & 0xFF);
+            out.push_back(offset >> 8);
+            if (match - minMatch >= 15)
+            {
+                length(match - minMatch);
+            }
+            i += match;
+            anchor = i;
+        }
+        size_t literals = size - anchor;
+        out.push_back(tako::U8(std::min<size_t>(literals, 15) << 4));
+        if (literals >= 15)
+        {
+            length(literals);
+        }
+        out.insert(out.end(), src + anchor, src + size);
+        return out;
+    }
+
+    struct PackSource
+    {
+        std::string path;
+        Kind kind;
+        int width = 0;
+        int height = 0;
+        std::vector<tako::U8> data;
+    };
+
+    // Reads an asset the way the game would get it: PNGs decoded to RGBA, everything else as is
+    bool ReadSource(const std::string& directory, const std::string& name, PackSource& source)
+    {
+        std::ifstream file(directory + "/" + name, std::ios::binary);
+        if (!file)
+        {
+            fprintf(stderr, "Could not read %s/%s\n", directory.c_str(), name.c_str());
+            return false;
+        }
+        std::stringstream content;
+        content << file.rdbuf();
+        auto bytes = content.str();
+        source.path = "/" + name;
+        if (name.size() > 4 && name.compare(name.size() - 4, 4, ".png") == 0)
+        {
+            PngImage image;
+            if (!Png::Decode(bytes, image))
+            {
+                fprintf(stderr, "Unsupported PNG %s, only 8 bit RGB(A) without interlacing is decoded\n", name.c_str());
+                return false;
+            }
+            source.kind = Kind::Image;
+            source.width = image.width;
+            source.height = image.height;
+            source.data = std::move(image.rgba);
+            return true;
+        }
+        source.kind = Kind::Raw;
+        source.data.assign(bytes.begin(), bytes.end());
+        return true;
+    }
+
+    // Compressed entries are only kept when they save at least an eighth, small ones stay mappable as they are
+    bool WriteArchive(const char* output, std::vector<PackSource> sources, bool compress)
+    {
+        std::sort(sources.begin(), sources.end(), [](const PackSource& a, const PackSource& b)
+        {
+            return a.path < b.path;
+        });
+        Header header = {};
+        memcpy(header.magic, magic, sizeof(magic));
+        header.version = version;
+        header.count = sources.size();
+        std::vector<Entry> entries(sources.size());
+        std::string paths;
+        size_t pathStart = sizeof(Header) + sizeof(Entry) * entries.size();
+        for (size_t i = 0; i < sources.size(); i++)
+        {
+            entries[i].pathOffset = pathStart + paths.size();
+            entries[i].pathLength = sources[i].path.size();
+            paths += sources[i].path;
+        }
+
+        std::vector<tako::U8> blob;
+        size_t dataStart = (pathStart + paths.size() + dataAlignment - 1) / dataAlignment * dataAlignment;
+        for (size_t i = 0; i < sources.size(); i++)
+        {
+            auto& source = sources[i];
+            auto& entry = entries[i];
+            entry.kind = source.kind;
+            entry.width = source.width;
+            entry.height = source.height;
+            entry.rawSize = source.data.size();
+            entry.compression = Compression::None;
+            std::vector<tako::U8> packed;
+            if (compress)
+            {
+                packed = Compress(source.data.data(), source.data.size());
+            }
+            auto& stored = compress && packed.size() <= source.data.size() * 7 / 8 ? packed : source.data;
+            if (&stored == &packed)
+            {
+                entry.compression = Compression::Lz;
+            }
+            blob.resize((blob.size() + dataAlignment - 1) / dataAlignment * dataAlignment);
+            entry.offset = dataStart + blob.size();
+            entry.size = stored.size();
+            blob.insert(blob.end(), stored.begin(), stored.end());
+        }
+
+        std::ofstream file(output, std::ios::binary);
+        if (!file)
+        {
+            fprintf(stderr, "Could not write %s\n", output);
+            return false;
+        }
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(entries.data()), sizeof(Entry) * entries.size());
+        file << paths;
+        file << std::string(dataStart - pathStart - paths.size(), '\0');
+        file.write(reinterpret_cast<const char*>(blob.data()), blob.size());
+        return bool(file);
+    }
+}
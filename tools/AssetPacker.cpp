@@ -0,0 +1,60 @@
+#include "AssetPack.hpp"
+#include <cstdio>
+#include <cstring>
+
+int main(int argc, char* argv[])
+{
+    const char* out = nullptr;
+    const char* directory = ".";
+    bool compress = false;
+    std::vector<std::string> names;
+    for (int i = 1; i < argc; i++)
+    {
+        const char* arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (strcmp(arg, "--compress") == 0)
+        {
+            compress = true;
+            continue;
+        }
+        if (strncmp(arg, "--", 2) != 0)
+        {
+            names.push_back(arg);
+            continue;
+        }
+        if (!value)
+        {
+            fprintf(stderr, "Missing value for %s\n", arg);
+            return 1;
+        }
+        if (strcmp(arg, "--dir") == 0)
+        {
+            directory = value;
+        }
+        else if (strcmp(arg, "--out") == 0)
+        {
+            out = value;
+        }
+        else
+        {
+            fprintf(stderr, "Usage: %s --out FILE [--dir DIR] [--compress] NAME...\n", argv[0]);
+            return 1;
+        }
+        i++;
+    }
+    if (!out || names.empty())
+    {
+        fprintf(stderr, "Usage: %s --out FILE [--dir DIR] [--compress] NAME...\n", argv[0]);
+        return 1;
+    }
+
+    std::vector<AssetPack::PackSource> sources(names.size());
+    for (size_t i = 0; i < names.size(); i++)
+    {
+        if (!AssetPack::ReadSource(directory, names[i], sources[i]))
+        {
+            return 1;
+        }
+    }
+    return AssetPack::WriteArchive(out, std::move(sources), compress) ? 0 : 1;
+}
@@ -0,0 +1,71 @@
+#include "LevelGenerator.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+int main(int argc, char* argv[])
+{
+    LevelSettings settings;
+    const char* out = nullptr;
+    for (int i = 1; i < argc; i++)
+    {
+        const char* arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (!value)
+        {
+            fprintf(stderr, "Missing value for %s\n", arg);
+            return 1;
+        }
+        if (strcmp(arg, "--width") == 0)
+        {
+            settings.width = atoi(value);
+        }
+        else if (strcmp(arg, "--height") == 0)
+        {
+            settings.height = atoi(value);
+        }
+        else if (strcmp(arg, "--spawners") == 0)
+        {
+            settings.spawners = atoi(value);
+        }
+        else if (strcmp(arg, "--plants") == 0)
+        {
+            settings.plants = atoi(value);
+        }
+        else if (strcmp(arg, "--seed") == 0)
+        {
+            settings.seed = strtoul(value, nullptr, 10);
+        }
+        else if (strcmp(arg, "--players") == 0)
+        {
+            settings.players = atoi(value);
+        }
+        else if (strcmp(arg, "--out") == 0)
+        {
+            out = value;
+        }
+        else
+        {
+            fprintf(stderr, "Usage: %s [--width N] [--height N] [--spawners N] [--plants N] [--seed N] [--players N] [--out FILE]\n", argv[0]);
+            return 1;
+        }
+        i++;
+    }
+
+    auto level = GenerateLevel(settings);
+    if (!out)
+    {
+        std::cout << level;
+        return 0;
+    }
+    std::ofstream file(out, std::ios::binary);
+    if (!file)
+    {
+        fprintf(stderr, "Could not write %s\n", out);
+        return 1;
+    }
+    file << level;
+    return 0;
+}
@@ -0,0 +1,125 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <random>
+#include <algorithm>
+
+struct LevelSettings
+{
+    int width = 47;
+    int height = 13;
+    int spawners = 4;
+    int plants = 30;
+    unsigned int seed = 0;
+    int players = 1;
+    // Columns between the carrot and the nearest players, the next pair stands that far further out
+    int playerSpacing = 1;
+};
+
+// Emits a level in the same character format as Assets/Level.txt, rows separated by '\n' without a trailing newline
+std::string GenerateLevel(LevelSettings settings)
+{
+    int width = std::max(settings.width, 12);
+    int height = std::max(settings.height, 8);
+    std::mt19937 rng(settings.seed);
+    auto random = [&](int min, int max)
+    {
+        return std::uniform_int_distribution<int>(min, max)(rng);
+    };
+
+    std::vector<std::string> rows(height, std::string(width, ' '));
+    auto solid = [&](int x, int y)
+    {
+        char c = rows[y][x];
+        return c != ' ' && c != 'p' && c != 'P' && c != 'S' && c != 'C';
+    };
+    auto standable = [&](int x, int y)
+    {
+        return rows[y][x] == ' ' && y + 1 < height && solid(x, y + 1);
+    };
+
+    for (int x = 0; x < width; x++)
+    {
+        rows[0][x] = x < 3 || x >= width - 3 ? '#' : '-';
+        rows[height - 1][x] = '#';
+        rows[height - 2][x] = x < 3 || x >= width - 3 ? '#' : (random(0, 2) == 0 ? 'G' : '=');
+    }
+    for (int y = 1; y < height - 2; y++)
+    {
+        rows[y].replace(0, 3, "##>");
+        rows[y].replace(width - 3, 3, "<##");
+    }
+
+    for (int y = height - 6; y >= 3; y -= 4)
+    {
+        int x = 4 + random(0, 6);
+        while (x < width - 8)
+        {
+            int length = random(3, 12);
+            if (x + length >= width - 4)
+            {
+                break;
+            }
+            bool hanging = random(0, 2) == 0;
+            rows[y][x] = hanging ? '(' : '[';
+            for (int i = 1; i < length - 1; i++)
+            {
+                rows[y][x + i] = hanging ? '_' : (random(0, 2) == 0 ? 'G' : '=');
+            }
+            rows[y][x + length - 1] = hanging ? ')' : ']';
+            x += length + random(3, 10);
+        }
+    }
+
+    int carrotX = width / 2;
+    rows[height - 3][carrotX] = 'C';
+    rows[height - 4][carrotX] = ' ';
+    for (int i = 0; i < settings.players; i++)
+    {
+        int offset = (i / 2 + 1) * settings.playerSpacing;
+        int x = i % 2 == 0 ? carrotX - offset : carrotX + offset;
+        if (x >= 3 && x < width - 3)
+        {
+            rows[height - 3][x] = 'P';
+        }
+    }
+
+    std::vector<std::pair<int, int>> plantCells;
+    std::vector<std::pair<int, int>> spawnCells;
+    for (int y = 1; y < height - 2; y++)
+    {
+        for (int x = 3; x < width - 3; x++)
+        {
+            if (standable(x, y) && std::abs(x - carrotX) > 1)
+            {
+                plantCells.emplace_back(x, y);
+            }
+            else if (rows[y][x] == ' ' && y <= std::max(1, height / 3))
+            {
+                spawnCells.emplace_back(x, y);
+            }
+        }
+    }
+    std::shuffle(plantCells.begin(), plantCells.end(), rng);
+    std::shuffle(spawnCells.begin(), spawnCells.end(), rng);
+    for (int i = 0; i < settings.plants && i < plantCells.size(); i++)
+    {
+        rows[plantCells[i].second][plantCells[i].first] = 'p';
+    }
+    for (int i = 0; i < settings.spawners && i < spawnCells.size(); i++)
+    {
+        rows[spawnCells[i].second][spawnCells[i].first] = 'S';
+    }
+
+    std::string level;
+    level.reserve((width + 1) * height);
+    for (int y = 0; y < height; y++)
+    {
+        level += rows[y];
+        if (y < height - 1)
+        {
+            level += '\n';
+        }
+    }
+    return level;
+}
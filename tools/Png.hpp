@@ -0,0 +1,385 @@
+#pragma once
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+// Minimal PNG decoder for the asset packer: 8 bit RGB or RGBA, no interlacing, which covers everything in Assets/
+struct PngImage
+{
+    int width = 0;
+    int height = 0;
+    std::vector<uint8_t> rgba;
+};
+
+namespace Png
+{
+    // Inflate of a complete zlib stream (RFC 1950/1951), stored, fixed and dynamic blocks
+    class Inflater
+    {
+    public:
+        Inflater(const uint8_t* data, size_t size) : m_data(data), m_size(size) {}
+
+        bool Run(std::vector<uint8_t>& out)
+        {
+            if (m_size < 2 || (m_data[0] & 0x0F) != 8 || ((m_data[0] << 8) | m_data[1]) % 31 != 0 || (m_data[1] & 0x20))
+            {
+                return false;
+            }
+            m_position = 2;
+            bool last = false;
+            while (!last)
+            {
+                last = Bits(1);
+                int type = Bits(2);
+                bool ok = false;
+                if (type == 0)
+                {
+                    ok = Stored(out);
+                }
+                else if (type == 1)
+                {
+                    ok = Fixed(out);
+                }
+                else if (type == 2)
+                {
+                    ok = Dynamic(out);
+                }
+                if (!ok || m_overrun)
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+    private:
+        struct Huffman
+        {
+            uint16_t counts[16];
+            uint16_t symbols[288];
+        };
+
+        int Bits(int count)
+        {
+            int value = 0;
+            for (int i = 0; i < count; i++)
+            {
+                if (m_position >= m_size)
+                {
+                    m_overrun = true;
+                    return 0;
+                }
+                value |= ((m_data[m_position] >> m_bit) & 1) << i;
+                if (++m_bit == 8)
+                {
+                    m_bit = 0;
+                    m_position++;
+                }
+            }
+            return value;
+        }
+
+        static bool Build(Huffman& huffman, const uint8_t* lengths, int count)
+        {
+            memset(huffman.counts, 0, sizeof(huffman.counts));
+            for (int i = 0; i < count; i++)
+            {
+                huffman.counts[lengths[i]]++;
+            }
+            huffman.counts[0] = 0;
+            uint16_t offsets[16] = {};
+            for (int i = 1; i < 16; i++)
+            {
+                offsets[i] = offsets[i - 1] + huffman.counts[i - 1];
+            }
+            for (int i = 0; i < count; i++)
+            {
+                if (lengths[i])
+                {
+                    huffman.symbols[offsets[lengths[i]]++] = i;
+                }
+            }
+            return true;
+        }
+
+        int Decode(const Huffman& huffman)
+        {
+            int code = 0;
+            int first = 0;
+            int index = 0;
+            for (int length = 1; length < 16; length++)
+            {
+                code |= Bits(1);
+                int count = huffman.counts[length];
+                if (code - count < first)
+                {
+                    return huffman.symbols[index + (code - first)];
+                }
+                index += count;
+                first = (first + count) << 1;
+                code <<= 1;
+            }
+            m_overrun = true;
+            return 0;
+        }
+
+        bool Stored(std::vector<uint8_t>& out)
+        {
+            if (m_bit)
+            {
+                m_bit = 0;
+                m_position++;
+            }
+            if (m_position + 4 > m_size)
+            {
+                return false;
+            }
+            size_t length = m_data[m_position] | (m_data[m_position + 1] << 8);
+            size_t check = m_data[m_position + 2] | (m_data[m_position + 3] << 8);
+            m_position += 4;
+            if ((length ^ 0xFFFF) != check || m_position + length > m_size)
+            {
+                return false;
+            }
+            out.insert(out.end(), m_data + m_position, m_data + m_position + length);
+            m_position += length;
+            return true;
+        }
+
+        bool Codes(std::vector<uint8_t>& out, const Huffman& lengths, const Huffman& distances)
+        {
+            static const uint16_t lengthBase[29] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+            static const uint8_t lengthExtra[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+            static const uint16_t distanceBase[30] = {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+            static const uint8_t distanceExtra[30] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+            while (!m_overrun)
+            {
+                int symbol = Decode(lengths);
+                if (symbol < 256)
+                {
+                    out.push_back(symbol);
+                    continue;
+                }
+                if (symbol == 256)
+                {
+                    return true;
+                }
+                symbol -= 257;
+                if (symbol >= 29)
+                {
+                    return false;
+                }
+                size_t length = lengthBase[symbol] + Bits(lengthExtra[symbol]);
+                int distanceSymbol = Decode(distances);
+                if (distanceSymbol >= 30)
+                {
+                    return false;
+                }
+                size_t distance = distanceBase[distanceSymbol] + Bits(distanceExtra[distanceSymbol]);
+                if (distance > out.size())
+                {
+                    return false;
+                }
+                size_t from = out.size() - distance;
+                for (size_t i = 0; i < length; i++)
+                {
+                    out.push_back(out[from + i]);
+                }
+            }
+            return false;
+        }
+
+        bool Fixed(std::vector<uint8_t>& out)
+        {
+            uint8_t lengths[288];
+            memset(lengths, 8, 144);
+            memset(lengths + 144, 9, 112);
+            memset(lengths + 256, 7, 24);
+            memset(lengths + 280, 8, 8);
+            uint8_t distanceLengths[30];
+            memset(distanceLengths, 5, 30);
+            Huffman lengthCodes, distanceCodes;
+            Build(lengthCodes, lengths, 288);
+            Build(distanceCodes, distanceLengths, 30);
+            return Codes(out, lengthCodes, distanceCodes);
+        }
+
+        bool Dynamic(std::vector<uint8_t>& out)
+        {
+            static const uint8_t order[19] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+            int lengthCount = Bits(5) + 257;
+            int distanceCount = Bits(5) + 1;
+            int codeCount = Bits(4) + 4;
+            if (lengthCount > 286 || distanceCount > 30)
+            {
+                return false;
+            }
+            uint8_t lengths[320] = {};
+            for (int i = 0; i < codeCount; i++)
+            {
+                lengths[order[i]] = Bits(3);
+            }
+            Huffman codes;
+            Build(codes, lengths, 19);
+            int index = 0;
+            while (index < lengthCount + distanceCount && !m_overrun)
+            {
+                int symbol = Decode(codes);
+                if (symbol < 16)
+                {
+                    lengths[index++] = symbol;
+                    continue;
+                }
+                int repeat = 0;
+                uint8_t value = 0;
+                if (symbol == 16)
+                {
+                    if (index == 0)
+                    {
+                        return false;
+                    }
+                    value = lengths[index - 1];
+                    repeat = 3 + Bits(2);
+                }
+                else if (symbol == 17)
+                {
+                    repeat = 3 + Bits(3);
+                }
+                else
+                {
+                    repeat = 11 + Bits(7);
+                }
+                if (index + repeat > lengthCount + distanceCount)
+                {
+                    return false;
+                }
+                memset(lengths + index, value, repeat);
+                index += repeat;
+            }
+            Huffman lengthCodes, distanceCodes;
+            Build(lengthCodes, lengths, lengthCount);
+            Build(distanceCodes, lengths + lengthCount, distanceCount);
+            return !m_overrun && Codes(out, lengthCodes, distanceCodes);
+        }
+
+        const uint8_t* m_data;
+        size_t m_size;
+        size_t m_position = 0;
+        int m_bit = 0;
+        bool m_overrun = false;
+    };
+
+    uint32_t ReadU32(const uint8_t* data)
+    {
+        return (uint32_t(data[0]) << 24) | (data[1] << 16) | (data[2] << 8) | data[3];
+    }
+
+    int Paeth(int a, int b, int c)
+    {
+        int p = a + b - c;
+        int pa = std::abs(p - a);
+        int pb = std::abs(p - b);
+        int pc = std::abs(p - c);
+        if (pa <= pb && pa <= pc)
+        {
+            return a;
+        }
+        return pb <= pc ? b : c;
+    }
+
+    bool Decode(std::string_view file, PngImage& image)
+    {
+        static const uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+        auto data = reinterpret_cast<const uint8_t*>(file.data());
+        if (file.size() < 8 || memcmp(data, signature, 8) != 0)
+        {
+            return false;
+        }
+        int channels = 0;
+        std::vector<uint8_t> compressed;
+        size_t position = 8;
+        while (position + 12 <= file.size())
+        {
+            uint32_t length = ReadU32(data + position);
+            std::string_view type(file.data() + position + 4, 4);
+            auto chunk = data + position + 8;
+            if (position + 12 + length > file.size())
+            {
+                return false;
+            }
+            if (type == "IHDR")
+            {
+                image.width = ReadU32(chunk);
+                image.height = ReadU32(chunk + 4);
+                int depth = chunk[8];
+                int color = chunk[9];
+                int interlace = chunk[12];
+                channels = color == 6 ? 4 : color == 2 ? 3 : 0;
+                if (depth != 8 || !channels || interlace)
+                {
+                    return false;
+                }
+            }
+            else if (type == "IDAT")
+            {
+                compressed.insert(compressed.end(), chunk, chunk + length);
+            }
+            else if (type == "IEND")
+            {
+                break;
+            }
+            position += 12 + length;
+        }
+        if (!channels)
+        {
+            return false;
+        }
+
+        std::vector<uint8_t> raw;
+        if (!Inflater(compressed.data(), compressed.size()).Run(raw))
+        {
+            return false;
+        }
+        size_t stride = size_t(image.width) * channels;
+        if (raw.size() < (stride + 1) * image.height)
+        {
+            return false;
+        }
+        std::vector<uint8_t> previous(stride, 0);
+        std::vector<uint8_t> row(stride);
+        image.rgba.resize(size_t(image.width) * image.height * 4);
+        for (int y = 0; y < image.height; y++)
+        {
+            auto line = raw.data() + y * (stride + 1);
+            int filter = line[0];
+            for (size_t i = 0; i < stride; i++)
+            {
+                int left = i >= size_t(channels) ? row[i - channels] : 0;
+                int up = previous[i];
+                int upLeft = i >= size_t(channels) ? previous[i - channels] : 0;
+                int value = line[i + 1];
+                switch (filter)
+                {
+                    case 1: value += left; break;
+                    case 2: value += up; break;
+                    case 3: value += (left + up) / 2; break;
+                    case 4: value += Paeth(left, up, upLeft); break;
+                }
+                row[i] = value;
+            }
+            for (int x = 0; x < image.width; x++)
+            {
+                auto pixel = image.rgba.data() + (size_t(y) * image.width + x) * 4;
+                memcpy(pixel, row.data() + x * channels, channels);
+                if (channels == 3)
+                {
+                    pixel[3] = 255;
+                }
+            }
+            std::swap(previous, row);
+        }
+        return true;
+    }
+}